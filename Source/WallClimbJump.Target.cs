@@ -10,5 +10,12 @@ public class WallClimbJumpTarget : TargetRules
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		ExtraModuleNames.Add("WallClimbJump");
+
+		// Keep "stat Traversal" available in the builds we profile in production
+		if (Target.Configuration == UnrealTargetConfiguration.Test || Target.Configuration == UnrealTargetConfiguration.Shipping)
+		{
+			BuildEnvironment = TargetBuildEnvironment.Unique;
+			GlobalDefinitions.Add("FORCE_USE_STATS=1");
+		}
 	}
 }
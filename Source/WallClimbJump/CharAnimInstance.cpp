@@ -3,3 +3,35 @@
 
 #include "CharAnimInstance.h"
 
+#include "WallClimbJumpCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+void FCharAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, const float DeltaSeconds)
+{
+	Super::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Game thread, copy out everything Update needs so it never touches the character
+	const AWallClimbJumpCharacter* Character = Cast<AWallClimbJumpCharacter>(InAnimInstance->TryGetPawnOwner());
+	if(!Character) return;
+	State = Character->GetAnimState();
+	Velocity = Character->GetVelocity();
+	bFalling = Character->GetCharacterMovement()->IsFalling();
+	GrappleTimeRemaining = Character->GetGrappleTimeRemaining();
+
+	UCharAnimInstance* AnimInstance = CastChecked<UCharAnimInstance>(InAnimInstance);
+	AnimInstance->bIsClimbing = State.bIsClimbing;
+	AnimInstance->Direction = State.Direction;
+	AnimInstance->bIsHolding = State.bIsHolding;
+	AnimInstance->JumpDirection = State.JumpDirection;
+	AnimInstance->bIsJumpingOff = State.bIsJumpingOff;
+	AnimInstance->bIsGrappling = State.bIsGrappling;
+}
+
+void FCharAnimInstanceProxy::Update(const float DeltaSeconds)
+{
+	Super::Update(DeltaSeconds);
+
+	Speed = Velocity.Size();
+	bIsInAir = bFalling;
+	bIsClimbPaused = State.bIsClimbing && Velocity.IsNearlyZero();
+}
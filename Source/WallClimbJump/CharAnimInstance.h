@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
 #include "CharAnimInstance.generated.h"
 
 /**
@@ -12,12 +13,68 @@
 UENUM()
 enum class EJumpDirection : uint8 { Left, Right };
 
+/** Traversal state the character hands to its animation */
+USTRUCT(BlueprintType)
+struct FTraversalAnimState
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsClimbing = false;
+	UPROPERTY(BlueprintReadOnly)
+	float Direction = 0.f;
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsHolding = false;
+	UPROPERTY(BlueprintReadOnly)
+	EJumpDirection JumpDirection = EJumpDirection::Left;
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsJumpingOff = false;
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsGrappling = false;
+};
+
+/**
+ * Snapshots the owning character on the game thread in PreUpdate, then derives
+ * everything else in Update, which runs on a worker when multi-threaded animation
+ * update is enabled.
+ */
+USTRUCT()
+struct WALLCLIMBJUMP_API FCharAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FCharAnimInstanceProxy() {}
+	FCharAnimInstanceProxy(UAnimInstance* InAnimInstance) : FAnimInstanceProxy(InAnimInstance) {}
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category=Traversal)
+	FTraversalAnimState State;
+	UPROPERTY(Transient, BlueprintReadOnly, Category=Movement)
+	float Speed = 0.f;
+	UPROPERTY(Transient, BlueprintReadOnly, Category=Movement)
+	bool bIsInAir = false;
+	/** True while climbing without moving, the graph can hold the climb pose instead of pausing the mesh */
+	UPROPERTY(Transient, BlueprintReadOnly, Category=Movement)
+	bool bIsClimbPaused = false;
+	/** Seconds until the grapple pull lands, zero when not grappling */
+	UPROPERTY(Transient, BlueprintReadOnly, Category=Traversal)
+	float GrappleTimeRemaining = 0.f;
+
+protected:
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void Update(float DeltaSeconds) override;
+
+private:
+	FVector Velocity = FVector::ZeroVector;
+	bool bFalling = false;
+};
+
 UCLASS()
 class WALLCLIMBJUMP_API UCharAnimInstance : public UAnimInstance
 {
 	GENERATED_BODY()
 
 public:
+	// Mirrors of the proxy snapshot for existing graph bindings, written before the update is dispatched
 	UPROPERTY(BlueprintReadOnly)
 	bool bIsClimbing;
 	UPROPERTY(BlueprintReadOnly)
@@ -30,5 +87,12 @@ public:
 	bool bIsJumpingOff;
 	UPROPERTY(BlueprintReadOnly)
 	bool bIsGrappling;
-	
+
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override { return &Proxy; }
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override {}
+
+	/** Bind graph pins to members of this struct so they stay on the fast path */
+	UPROPERTY(Transient, BlueprintReadOnly, Category=Traversal, meta=(AllowPrivateAccess="true"))
+	FCharAnimInstanceProxy Proxy;
 };
@@ -0,0 +1,510 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ClimbMovementComponent.h"
+
+#include "ClimbableWall.h"
+#include "Ledge.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PhysicsVolume.h"
+
+namespace ClimbMovement
+{
+	static_assert(CMOVE_MAX <= 4, "Traversal modes are sent in two compressed flag bits");
+
+	uint8 EncodeTraversalMode(const uint8 Mode)
+	{
+		return ((Mode & 1) ? FSavedMove_Character::FLAG_Custom_0 : 0) | ((Mode & 2) ? FSavedMove_Character::FLAG_Custom_1 : 0);
+	}
+
+	uint8 DecodeTraversalMode(const uint8 Flags)
+	{
+		return ((Flags & FSavedMove_Character::FLAG_Custom_0) ? 1 : 0) | ((Flags & FSavedMove_Character::FLAG_Custom_1) ? 2 : 0);
+	}
+
+	bool IsAnchoredMode(const uint8 Mode)
+	{
+		return Mode == CMOVE_Hang || Mode == CMOVE_Grapple;
+	}
+
+	/** A hop sets the third custom flag, the fourth when it goes left */
+	uint8 EncodeHop(const int8 Direction)
+	{
+		if(Direction == 0) return 0;
+		return FSavedMove_Character::FLAG_Custom_2 | (Direction < 0 ? FSavedMove_Character::FLAG_Custom_3 : 0);
+	}
+
+	int8 DecodeHop(const uint8 Flags)
+	{
+		if(!(Flags & FSavedMove_Character::FLAG_Custom_2)) return 0;
+		return (Flags & FSavedMove_Character::FLAG_Custom_3) ? -1 : 1;
+	}
+}
+
+void FGrappleTrajectory::Init(const FVector& InStart, const FVector& InEnd, const float InDuration, const float ArcHeight)
+{
+	Start = InStart;
+	End = InEnd;
+	Control = (InStart + InEnd) * 0.5f + FVector::UpVector * ArcHeight;
+	Duration = InDuration;
+	Elapsed = 0.f;
+}
+
+FVector FGrappleTrajectory::Evaluate() const
+{
+	// Ease in and out along a quadratic Bezier
+	const float T = FMath::InterpEaseInOut(0.f, 1.f, GetAlpha(), 2.f);
+	const float InvT = 1.f - T;
+	return InvT * InvT * Start + 2.f * InvT * T * Control + T * T * End;
+}
+
+void FSavedMove_Climb::Clear()
+{
+	Super::Clear();
+	SavedTraversalMode = CMOVE_None;
+	SavedTraversalAnchor = FVector::ZeroVector;
+	SavedTraversalLedge.Reset();
+	SavedHopDirection = 0;
+	SavedGrappleTrajectory = FGrappleTrajectory();
+	SavedAlignmentTarget = FQuat::Identity;
+	SavedAlignmentAccumulator = 0.f;
+	bSavedIsAligning = false;
+}
+
+uint8 FSavedMove_Climb::GetCompressedFlags() const
+{
+	return Super::GetCompressedFlags() | ClimbMovement::EncodeTraversalMode(SavedTraversalMode) | ClimbMovement::EncodeHop(SavedHopDirection);
+}
+
+bool FSavedMove_Climb::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, const float MaxDelta) const
+{
+	const FSavedMove_Climb* Other = static_cast<const FSavedMove_Climb*>(NewMove.Get());
+	if(SavedTraversalMode != Other->SavedTraversalMode || SavedTraversalAnchor != Other->SavedTraversalAnchor || SavedTraversalLedge != Other->SavedTraversalLedge) return false;
+	if(SavedHopDirection != 0 || Other->SavedHopDirection != 0) return false;
+	// Combining doesn't rewind the alignment steps the pending move already took
+	if(bSavedIsAligning || Other->bSavedIsAligning) return false;
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Climb::SetMoveFor(ACharacter* C, const float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+	if(const UClimbMovementComponent* Movement = Cast<UClimbMovementComponent>(C->GetCharacterMovement()))
+	{
+		SavedTraversalMode = Movement->RequestedTraversalMode;
+		SavedTraversalAnchor = Movement->TraversalAnchor;
+		SavedTraversalLedge = Movement->TraversalLedge;
+		SavedHopDirection = Movement->PendingHopDirection;
+		SavedGrappleTrajectory = Movement->GrappleTrajectory;
+		SavedAlignmentTarget = Movement->AlignmentTarget;
+		SavedAlignmentAccumulator = Movement->AlignmentAccumulator;
+		bSavedIsAligning = Movement->bIsAligning;
+	}
+}
+
+void FSavedMove_Climb::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+	if(UClimbMovementComponent* Movement = Cast<UClimbMovementComponent>(C->GetCharacterMovement()))
+	{
+		Movement->RequestedTraversalMode = SavedTraversalMode;
+		Movement->TraversalAnchor = SavedTraversalAnchor;
+		Movement->TraversalLedge = SavedTraversalLedge;
+		Movement->PendingHopDirection = SavedHopDirection;
+		Movement->GrappleTrajectory = SavedGrappleTrajectory;
+		Movement->AlignmentTarget = SavedAlignmentTarget;
+		Movement->AlignmentAccumulator = SavedAlignmentAccumulator;
+		Movement->bIsAligning = bSavedIsAligning;
+	}
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Climb::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Climb());
+}
+
+void FClimbNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, const ENetworkMoveType MoveType)
+{
+	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
+	const FSavedMove_Climb& ClimbMove = static_cast<const FSavedMove_Climb&>(ClientMove);
+	TraversalAnchor = ClimbMove.SavedTraversalAnchor;
+	TraversalLedge = ClimbMove.SavedTraversalLedge.Get();
+}
+
+bool FClimbNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, const ENetworkMoveType MoveType)
+{
+	Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+	// The flags were serialized first, so both sides agree on whether an anchor follows
+	if(ClimbMovement::IsAnchoredMode(ClimbMovement::DecodeTraversalMode(CompressedMoveFlags)))
+	{
+		bool bLocalSuccess = true;
+		TraversalAnchor.NetSerialize(Ar, PackageMap, bLocalSuccess);
+		UObject* Ledge = TraversalLedge;
+		Ar << Ledge;
+		TraversalLedge = Cast<ALedge>(Ledge);
+	}
+	return !Ar.IsError();
+}
+
+UClimbMovementComponent::UClimbMovementComponent()
+{
+	SetNetworkMoveDataContainer(ClimbMoveDataContainer);
+}
+
+void UClimbMovementComponent::StartClimbing()
+{
+	SetMovementMode(MOVE_Custom, CMOVE_Climb);
+	StopMovementImmediately();
+}
+
+void UClimbMovementComponent::StartHanging(const FVector& HangLocation, ALedge* Ledge)
+{
+	TraversalAnchor = HangLocation;
+	TraversalLedge = Ledge;
+	if(CharacterOwner)
+	{
+		CharacterOwner->SetActorLocation(HangLocation);
+	}
+	SetMovementMode(MOVE_Custom, CMOVE_Hang);
+	StopMovementImmediately();
+}
+
+void UClimbMovementComponent::StartGrappleTravel(const FVector& Destination, ALedge* Ledge)
+{
+	GrappleDestination = Destination;
+	TraversalAnchor = Destination;
+	TraversalLedge = Ledge;
+	const FVector Start = UpdatedComponent ? UpdatedComponent->GetComponentLocation() : Destination;
+	const float Duration = FMath::Clamp(FVector::Dist(Start, Destination) / GrappleSpeed, MinGrappleDuration, MaxGrappleDuration);
+	GrappleTrajectory.Init(Start, Destination, Duration, GrappleArcHeight);
+	SetMovementMode(MOVE_Custom, CMOVE_Grapple);
+	StopMovementImmediately();
+}
+
+void UClimbMovementComponent::HopOffLedge(const int32 Direction)
+{
+	PendingHopDirection = static_cast<int8>(FMath::Sign(Direction));
+}
+
+void UClimbMovementComponent::AlignToSurface(const FVector& SurfaceNormal)
+{
+	const FVector Facing = FVector(-SurfaceNormal.X, -SurfaceNormal.Y, 0.f).GetSafeNormal();
+	if(Facing.IsZero() || !UpdatedComponent)
+	{
+		StopAligning();
+		return;
+	}
+	const FQuat Target = FRotator(0.f, Facing.Rotation().Yaw, 0.f).Quaternion();
+	if(bIsAligning && Target.Equals(AlignmentTarget)) return;
+	AlignmentTarget = Target;
+	if(!bIsAligning)
+	{
+		AlignmentAccumulator = 0.f;
+	}
+	bIsAligning = !UpdatedComponent->GetComponentQuat().Equals(AlignmentTarget);
+}
+
+void UClimbMovementComponent::StopAligning()
+{
+	bIsAligning = false;
+	AlignmentAccumulator = 0.f;
+}
+
+float UClimbMovementComponent::GetMaxSpeed() const
+{
+	if(MovementMode == MOVE_Custom)
+	{
+		switch(CustomMovementMode)
+		{
+		case CMOVE_Climb:
+			return MaxClimbSpeed;
+		case CMOVE_Hang:
+			return MaxHangSpeed;
+		default:
+			break;
+		}
+	}
+	return Super::GetMaxSpeed();
+}
+
+float UClimbMovementComponent::GetMaxBrakingDeceleration() const
+{
+	if(MovementMode == MOVE_Custom)
+	{
+		switch(CustomMovementMode)
+		{
+		case CMOVE_Climb:
+			return BrakingDecelerationClimbing;
+		case CMOVE_Hang:
+			return BrakingDecelerationHanging;
+		default:
+			break;
+		}
+	}
+	return Super::GetMaxBrakingDeceleration();
+}
+
+void UClimbMovementComponent::PhysicsRotation(const float DeltaTime)
+{
+	if(!bIsAligning)
+	{
+		Super::PhysicsRotation(DeltaTime);
+		return;
+	}
+	if(!HasValidData() || (!CharacterOwner->Controller && !bRunPhysicsWithNoController)) return;
+
+	// Step at a fixed rate so the turn takes the same number of steps at any frame rate and on every machine
+	const float StepTime = 1.f / AlignmentStepRate;
+	const float MaxStepAngle = FMath::DegreesToRadians(AlignmentRate) * StepTime;
+	AlignmentAccumulator += DeltaTime;
+	FQuat Rotation = UpdatedComponent->GetComponentQuat();
+	int32 Steps = 0;
+	while(AlignmentAccumulator >= StepTime && Steps < MaxAlignmentStepsPerFrame && bIsAligning)
+	{
+		AlignmentAccumulator -= StepTime;
+		++Steps;
+		const float Remaining = Rotation.AngularDistance(AlignmentTarget);
+		if(Remaining <= MaxStepAngle)
+		{
+			Rotation = AlignmentTarget;
+			StopAligning();
+		}
+		else
+		{
+			Rotation = FQuat::Slerp(Rotation, AlignmentTarget, MaxStepAngle / Remaining);
+		}
+	}
+	if(Steps == MaxAlignmentStepsPerFrame)
+	{
+		AlignmentAccumulator = FMath::Min(AlignmentAccumulator, StepTime);
+	}
+	if(Steps > 0)
+	{
+		// One transform update per frame however many steps were taken
+		MoveUpdatedComponent(FVector::ZeroVector, Rotation, false);
+	}
+}
+
+void UClimbMovementComponent::PhysCustom(const float deltaTime, const int32 Iterations)
+{
+	switch(CustomMovementMode)
+	{
+	case CMOVE_Climb:
+	case CMOVE_Hang:
+		PhysSurface(deltaTime, Iterations);
+		break;
+	case CMOVE_Grapple:
+		PhysGrapple(deltaTime, Iterations);
+		break;
+	default:
+		Super::PhysCustom(deltaTime, Iterations);
+		break;
+	}
+}
+
+void UClimbMovementComponent::OnMovementModeChanged(const EMovementMode PreviousMovementMode, const uint8 PreviousCustomMode)
+{
+	const bool bWasTraversing = PreviousMovementMode == MOVE_Custom && PreviousCustomMode > CMOVE_None && PreviousCustomMode < CMOVE_MAX;
+	if(!bWasTraversing && IsTraversing())
+	{
+		// The owner turns to face the surface itself while traversing
+		bOrientRotationBeforeTraversal = bOrientRotationToMovement;
+		bOrientRotationToMovement = false;
+	}
+	else if(bWasTraversing && !IsTraversing())
+	{
+		bOrientRotationToMovement = bOrientRotationBeforeTraversal;
+	}
+	// Saved moves record the mode so the server and replays can follow the client into and out of it
+	RequestedTraversalMode = IsTraversing() ? CustomMovementMode : CMOVE_None;
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+}
+
+void UClimbMovementComponent::UpdateFromCompressedFlags(const uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+	RequestedTraversalMode = ClimbMovement::DecodeTraversalMode(Flags);
+	PendingHopDirection = ClimbMovement::DecodeHop(Flags);
+	if(const FCharacterNetworkMoveData* MoveData = GetCurrentNetworkMoveData())
+	{
+		const FClimbNetworkMoveData* ClimbMoveData = static_cast<const FClimbNetworkMoveData*>(MoveData);
+		TraversalAnchor = ClimbMoveData->TraversalAnchor;
+		TraversalLedge = ClimbMoveData->TraversalLedge;
+	}
+}
+
+void UClimbMovementComponent::UpdateCharacterStateBeforeMovement(const float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+	if(PendingHopDirection != 0)
+	{
+		// Only off a ledge, leaving the mode clears RequestedTraversalMode so the hop decides where the move goes
+		const int8 HopDirection = PendingHopDirection;
+		PendingHopDirection = 0;
+		if(CharacterOwner && IsInCustomMode(CMOVE_Hang))
+		{
+			SetMovementMode(MOVE_Falling);
+			AddImpulse(CharacterOwner->GetActorRightVector() * HopDirection * HopOffSpeed, true);
+			return;
+		}
+	}
+	const uint8 CurrentMode = IsTraversing() ? CustomMovementMode : CMOVE_None;
+	if(RequestedTraversalMode == CurrentMode) return;
+
+	// A remote client's anchor is only a request, if it doesn't hold up the server stays put and corrects the client
+	FVector Anchor = TraversalAnchor;
+	const bool bRemoteClient = CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_Authority && !CharacterOwner->IsLocallyControlled();
+	if(bRemoteClient)
+	{
+		if(ClimbMovement::IsAnchoredMode(RequestedTraversalMode) && !ValidateTraversalAnchor(RequestedTraversalMode, Anchor)) return;
+		// Climbing ignores gravity, so it can only start where the client could have attached to a wall
+		if(RequestedTraversalMode == CMOVE_Climb && !IsInClimbZone()) return;
+	}
+	switch(RequestedTraversalMode)
+	{
+	case CMOVE_Climb:
+		StartClimbing();
+		break;
+	case CMOVE_Hang:
+		StartHanging(Anchor, TraversalLedge.Get());
+		break;
+	case CMOVE_Grapple:
+		StartGrappleTravel(Anchor, TraversalLedge.Get());
+		break;
+	default:
+		SetMovementMode(MOVE_Falling);
+		break;
+	}
+}
+
+bool UClimbMovementComponent::ValidateTraversalAnchor(const uint8 Mode, FVector& InOutAnchor) const
+{
+	return ClampToLedge(TraversalLedge.Get(), Mode == CMOVE_Grapple ? MaxGrappleDistance : MaxHangReach, InOutAnchor);
+}
+
+bool UClimbMovementComponent::IsInClimbZone() const
+{
+	if(!UpdatedPrimitive) return false;
+	// Walls block the capsule, the only thing of theirs it can overlap is the climb zone
+	for(const FOverlapInfo& Overlap : UpdatedPrimitive->GetOverlapInfos())
+	{
+		if(Cast<AClimbableWall>(Overlap.OverlapInfo.GetActor())) return true;
+	}
+	return false;
+}
+
+bool UClimbMovementComponent::ClampToLedge(const ALedge* Ledge, const float Reach, FVector& InOutPoint) const
+{
+	if(!Ledge || !UpdatedComponent) return false;
+
+	FVector EdgePoint;
+	if(Ledge->HasGrabSegment())
+	{
+		EdgePoint = Ledge->GetGrabSegment().GetClosestPoint(InOutPoint);
+	}
+	else if(Ledge->GetDistanceToGrabPoint(InOutPoint, EdgePoint) < 0.f)
+	{
+		return false;
+	}
+	InOutPoint = EdgePoint + (InOutPoint - EdgePoint).GetClampedToMaxSize(MaxAnchorOffset);
+
+	if(Reach <= 0.f) return true;
+	FVector ReachPoint;
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	if(Ledge->GetDistanceToGrabPoint(Location, ReachPoint) < 0.f) return false;
+	return FVector::Dist(Location, ReachPoint) <= Reach;
+}
+
+FNetworkPredictionData_Client* UClimbMovementComponent::GetPredictionData_Client() const
+{
+	if(!ClientPredictionData)
+	{
+		UClimbMovementComponent* MutableThis = const_cast<UClimbMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Climb(*this);
+	}
+	return ClientPredictionData;
+}
+
+void UClimbMovementComponent::PhysSurface(const float deltaTime, int32 Iterations)
+{
+	if(deltaTime < MIN_TICK_TIME) return;
+
+	float RemainingTime = deltaTime;
+	while(RemainingTime >= MIN_TICK_TIME && Iterations < MaxSimulationIterations && CharacterOwner && IsTraversing())
+	{
+		Iterations++;
+		bJustTeleported = false;
+		const float TimeTick = GetSimulationTimeStep(RemainingTime, Iterations);
+		RemainingTime -= TimeTick;
+
+		RestorePreAdditiveRootMotionVelocity();
+		if(!HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity())
+		{
+			// Same friction the flying mode used to apply when it stood in for these modes
+			CalcVelocity(TimeTick, 0.5f * GetPhysicsVolume()->FluidFriction, true, GetMaxBrakingDeceleration());
+		}
+		ApplyRootMotionToVelocity(TimeTick);
+
+		const FVector Delta = Velocity * TimeTick;
+		if(Delta.IsNearlyZero())
+		{
+			// Holding still, nothing will move in the remaining substeps either
+			break;
+		}
+		const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+		FHitResult Hit(1.f);
+		SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
+		if(Hit.IsValidBlockingHit())
+		{
+			HandleImpact(Hit, TimeTick, Delta);
+		}
+		if(!bJustTeleported && !HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity())
+		{
+			Velocity = (UpdatedComponent->GetComponentLocation() - OldLocation) / TimeTick;
+		}
+	}
+}
+
+void UClimbMovementComponent::PhysGrapple(const float deltaTime, int32 Iterations)
+{
+	if(deltaTime < MIN_TICK_TIME) return;
+
+	float RemainingTime = deltaTime;
+	while(RemainingTime >= MIN_TICK_TIME && Iterations < MaxSimulationIterations)
+	{
+		Iterations++;
+		bJustTeleported = false;
+		const float TimeTick = GetSimulationTimeStep(RemainingTime, Iterations);
+		RemainingTime -= TimeTick;
+
+		const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+		GrappleTrajectory.Advance(TimeTick);
+		const FVector Delta = GrappleTrajectory.Evaluate() - OldLocation;
+		FHitResult Hit(1.f);
+		SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
+		const FVector NewLocation = UpdatedComponent->GetComponentLocation();
+		Velocity = (NewLocation - OldLocation) / TimeTick;
+
+		// Geometry around the ledge can stop the capsule just short of the destination, count that as arriving too
+		const bool bStuck = Hit.bBlockingHit && (NewLocation - OldLocation).IsNearlyZero();
+		if(bStuck || GrappleTrajectory.IsComplete())
+		{
+			// Snapping from further out could pull the capsule through whatever stopped it
+			const bool bHanging = FVector::Dist(NewLocation, GrappleDestination) <= GrappleCatchDistance;
+			if(bHanging)
+			{
+				StartHanging(GrappleDestination, TraversalLedge.Get());
+			}
+			else
+			{
+				SetMovementMode(MOVE_Falling);
+			}
+			if(!CharacterOwner || !CharacterOwner->bClientUpdating)
+			{
+				OnGrappleArrived.Broadcast(bHanging);
+			}
+			StartNewPhysics(RemainingTime, Iterations);
+			return;
+		}
+	}
+}
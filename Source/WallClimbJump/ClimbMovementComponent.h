@@ -0,0 +1,248 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "ClimbMovementComponent.generated.h"
+
+/** Sub-modes of MOVE_Custom handled by UClimbMovementComponent */
+UENUM(BlueprintType)
+enum ECustomMovementMode
+{
+	CMOVE_None UMETA(Hidden),
+	CMOVE_Climb UMETA(DisplayName="Climbing"),
+	CMOVE_Hang UMETA(DisplayName="Hanging"),
+	CMOVE_Grapple UMETA(DisplayName="Grappling"),
+	CMOVE_MAX UMETA(Hidden)
+};
+
+class ALedge;
+
+/** bHanging is false when the pull was stopped short of the ledge and the character dropped instead */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGrappleArrived, bool /*bHanging*/);
+
+/** Eased path from the launch point to the grapple destination with a fixed duration, evaluated in constant time */
+USTRUCT(BlueprintType)
+struct FGrappleTrajectory
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector Start = FVector::ZeroVector;
+	UPROPERTY(BlueprintReadOnly)
+	FVector End = FVector::ZeroVector;
+	/** Bezier control point, raised above the midpoint to arc the path */
+	UPROPERTY(BlueprintReadOnly)
+	FVector Control = FVector::ZeroVector;
+	UPROPERTY(BlueprintReadOnly)
+	float Duration = 0.f;
+	UPROPERTY(BlueprintReadOnly)
+	float Elapsed = 0.f;
+
+	void Init(const FVector& InStart, const FVector& InEnd, float InDuration, float ArcHeight);
+	void Advance(const float DeltaTime) { Elapsed = FMath::Min(Elapsed + DeltaTime, Duration); }
+	FVector Evaluate() const;
+
+	bool IsComplete() const { return Elapsed >= Duration; }
+	float GetAlpha() const { return Duration > 0.f ? Elapsed / Duration : 1.f; }
+	float GetTimeRemaining() const { return Duration - Elapsed; }
+};
+
+/**
+ * Client move carrying the traversal mode the client was in and, for hang and grapple, where and to which ledge it is
+ * anchored, along with any hop off a ledge made that move
+ */
+class FSavedMove_Climb : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	uint8 SavedTraversalMode = CMOVE_None;
+	FVector SavedTraversalAnchor = FVector::ZeroVector;
+	TWeakObjectPtr<ALedge> SavedTraversalLedge;
+	int8 SavedHopDirection = 0;
+	/** Grapple path as it was before the move, so replaying the move advances it from the same point */
+	FGrappleTrajectory SavedGrappleTrajectory;
+	/** Surface alignment as it was before the move, so a replay takes the same fixed steps the first run did */
+	FQuat SavedAlignmentTarget = FQuat::Identity;
+	float SavedAlignmentAccumulator = 0.f;
+	bool bSavedIsAligning = false;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* C) override;
+};
+
+class FNetworkPredictionData_Client_Climb : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	explicit FNetworkPredictionData_Client_Climb(const UCharacterMovementComponent& ClientMovement) : Super(ClientMovement) {}
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
+
+/** Move data sent to the server, the anchor and its ledge are only serialized for moves that need one */
+struct FClimbNetworkMoveData : public FCharacterNetworkMoveData
+{
+	typedef FCharacterNetworkMoveData Super;
+
+	FVector_NetQuantize10 TraversalAnchor;
+	ALedge* TraversalLedge = nullptr;
+
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+};
+
+struct FClimbNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FClimbNetworkMoveDataContainer()
+	{
+		NewMoveData = &ClimbMoveData[0];
+		PendingMoveData = &ClimbMoveData[1];
+		OldMoveData = &ClimbMoveData[2];
+	}
+
+	FClimbNetworkMoveData ClimbMoveData[3];
+};
+
+/**
+ * Character movement with native modes for climbing walls, hanging from ledges and
+ * travelling along a grapple. The owning pawn decides when to enter each mode, so
+ * AI pawns can use the same component as the player.
+ */
+UCLASS()
+class WALLCLIMBJUMP_API UClimbMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_Climb;
+
+public:
+	UClimbMovementComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float MaxClimbSpeed = 100.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float BrakingDecelerationClimbing = 80.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float MaxHangSpeed = 50.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float BrakingDecelerationHanging = 110.f;
+
+	/** Average speed of grapple travel, the trajectory's duration is the distance over this clamped to the min and max */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="1", UIMin="1"))
+	float GrappleSpeed = 2000.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float MinGrappleDuration = 0.25f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float MaxGrappleDuration = 1.5f;
+	/** Height the grapple path bows above a straight line at its midpoint */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing")
+	float GrappleArcHeight = 0.f;
+
+	/** Sideways speed given when hopping off the end of a ledge */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float HopOffSpeed = 970.f;
+
+	/** Furthest a remote client's hang or grapple anchor may be from its ledge's edge, the server pulls it back in past this */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float MaxAnchorOffset = 300.f;
+	/** Furthest from a ledge's edge the server lets a remote client start hanging from it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float MaxHangReach = 250.f;
+	/** Furthest from a ledge's edge the server lets a remote client grapple to it, owners with a grapple range replace this */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="1", UIMin="1"))
+	float MaxGrappleDistance = 10000.f;
+
+	/** Yaw rate, in deg/sec, used to turn the character to face the surface it is traversing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float AlignmentRate = 60.f;
+	/** Fixed rate, in Hz, at which surface alignment is stepped regardless of frame rate */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="1", UIMin="1"))
+	float AlignmentStepRate = 60.f;
+	/** Upper bound on alignment steps taken in one frame, time beyond that is dropped to avoid spiralling on hitches */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="1", UIMin="1"))
+	int32 MaxAlignmentStepsPerFrame = 8;
+
+	/** How close to the destination a grapple stopped by geometry still catches the ledge, further out the character falls */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Climbing", meta=(ClampMin="0", UIMin="0"))
+	float GrappleCatchDistance = 50.f;
+
+	/** Broadcast when grapple travel ends, the component has already switched to hanging or falling. Not broadcast for replayed moves */
+	FOnGrappleArrived OnGrappleArrived;
+
+	UFUNCTION(BlueprintCallable, Category="Pawn|Components|CharacterMovement")
+	void StartClimbing();
+	/** Ledge is sent along with the move so the server can check the hang location against it */
+	UFUNCTION(BlueprintCallable, Category="Pawn|Components|CharacterMovement")
+	void StartHanging(const FVector& HangLocation, ALedge* Ledge = nullptr);
+	UFUNCTION(BlueprintCallable, Category="Pawn|Components|CharacterMovement")
+	void StartGrappleTravel(const FVector& Destination, ALedge* Ledge = nullptr);
+	/** Lets go of the ledge with a push to the character's right, or left for a negative Direction, on the next move */
+	UFUNCTION(BlueprintCallable, Category="Pawn|Components|CharacterMovement")
+	void HopOffLedge(int32 Direction);
+
+	/** Turns the character about yaw until it faces into SurfaceNormal, replaces rotation to movement until aligned */
+	UFUNCTION(BlueprintCallable, Category="Pawn|Components|CharacterMovement")
+	void AlignToSurface(const FVector& SurfaceNormal);
+	UFUNCTION(BlueprintCallable, Category="Pawn|Components|CharacterMovement")
+	void StopAligning();
+	UFUNCTION(BlueprintPure, Category="Pawn|Components|CharacterMovement")
+	bool IsAligning() const { return bIsAligning; }
+
+	UFUNCTION(BlueprintPure, Category="Pawn|Components|CharacterMovement")
+	bool IsInCustomMode(ECustomMovementMode Mode) const { return MovementMode == MOVE_Custom && CustomMovementMode == Mode; }
+	/** True while in any of the climb, hang or grapple modes */
+	UFUNCTION(BlueprintPure, Category="Pawn|Components|CharacterMovement")
+	bool IsTraversing() const { return MovementMode == MOVE_Custom && CustomMovementMode > CMOVE_None && CustomMovementMode < CMOVE_MAX; }
+
+	FVector GetGrappleDestination() const { return GrappleDestination; }
+	/** Ledge being hung from or grappled to, if the mode was entered with one */
+	ALedge* GetTraversalLedge() const { return TraversalLedge.Get(); }
+	/** Moves Point to within MaxAnchorOffset of Ledge's edge and checks the edge is within Reach of the character, 0 for no limit */
+	bool ClampToLedge(const ALedge* Ledge, float Reach, FVector& InOutPoint) const;
+	/** Path of the current or last grapple, its duration is known as soon as travel starts */
+	const FGrappleTrajectory& GetGrappleTrajectory() const { return GrappleTrajectory; }
+	UFUNCTION(BlueprintPure, Category="Pawn|Components|CharacterMovement")
+	float GetGrappleTimeRemaining() const { return IsInCustomMode(CMOVE_Grapple) ? GrappleTrajectory.GetTimeRemaining() : 0.f; }
+
+	virtual float GetMaxSpeed() const override;
+	virtual float GetMaxBrakingDeceleration() const override;
+	virtual void PhysicsRotation(float DeltaTime) override;
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+protected:
+	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+	/** Climbing and hanging, input driven movement along the surface without gravity */
+	void PhysSurface(float deltaTime, int32 Iterations);
+	void PhysGrapple(float deltaTime, int32 Iterations);
+	/** Moves a remote client's anchor onto TraversalLedge, false if the ledge is missing or out of reach */
+	bool ValidateTraversalAnchor(uint8 Mode, FVector& InOutAnchor) const;
+	/** Whether the updated component overlaps an AClimbableWall's climb zone */
+	bool IsInClimbZone() const;
+
+private:
+	FVector GrappleDestination;
+	FGrappleTrajectory GrappleTrajectory;
+	/** Traversal mode the owning client is in, replayed on the server and during client corrections */
+	uint8 RequestedTraversalMode = CMOVE_None;
+	/** Hang location or grapple destination that goes with RequestedTraversalMode */
+	FVector TraversalAnchor = FVector::ZeroVector;
+	TWeakObjectPtr<ALedge> TraversalLedge;
+	/** Hop waiting for the next move, saved with it so the server and replays make it too */
+	int8 PendingHopDirection = 0;
+	FClimbNetworkMoveDataContainer ClimbMoveDataContainer;
+	FQuat AlignmentTarget = FQuat::Identity;
+	float AlignmentAccumulator = 0.f;
+	bool bIsAligning = false;
+	bool bOrientRotationBeforeTraversal = true;
+};
@@ -3,8 +3,9 @@
 
 #include "ClimbableWall.h"
 
-// #include "WallClimbJumpCharacter.h"
-// #include "Components/BoxComponent.h"
+#include "WallClimbJumpCharacter.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
 
 // Sets default values
 AClimbableWall::AClimbableWall()
@@ -12,3 +13,59 @@ AClimbableWall::AClimbableWall()
 
 }
 
+void AClimbableWall::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Fit the zone around the wall's own collision, in actor space
+	const FBox LocalBounds = CalculateWallLocalBounds();
+	if(!LocalBounds.IsValid || !GetRootComponent()) return;
+
+	// Added under the blueprint's own root at runtime, a native root would displace placed walls from their saved transforms
+	ClimbZone = NewObject<UBoxComponent>(this, TEXT("ClimbZone"));
+	ClimbZone->SetupAttachment(GetRootComponent());
+	ClimbZone->SetCollisionProfileName(TEXT("Trigger"));
+	ClimbZone->SetCollisionResponseToChannel(ECC_GameTraceChannel1, ECR_Ignore);
+	ClimbZone->OnComponentBeginOverlap.AddDynamic(this, &AClimbableWall::OnClimbZoneBeginOverlap);
+	ClimbZone->OnComponentEndOverlap.AddDynamic(this, &AClimbableWall::OnClimbZoneEndOverlap);
+
+	const FVector Scale = GetActorScale3D().GetAbs().ComponentMax(FVector(KINDA_SMALL_NUMBER));
+	ClimbZone->SetRelativeLocation(LocalBounds.GetCenter());
+	ClimbZone->SetBoxExtent(LocalBounds.GetExtent() + FVector(ClimbZonePadding) / Scale, false);
+	ClimbZone->RegisterComponent();
+	// Characters already standing inside the zone still get told about it
+	ClimbZone->UpdateOverlaps();
+}
+
+FBox AClimbableWall::GetWallBounds() const
+{
+	const FBox LocalBounds = CalculateWallLocalBounds();
+	return LocalBounds.IsValid ? LocalBounds.TransformBy(GetActorTransform()) : FBox(ForceInit);
+}
+
+FBox AClimbableWall::CalculateWallLocalBounds() const
+{
+	FBox LocalBounds(ForceInit);
+	const FTransform& ActorTransform = GetActorTransform();
+	for(UActorComponent* Component : GetComponents())
+	{
+		const UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+		if(!Primitive || Primitive == ClimbZone || !Primitive->IsCollisionEnabled()) continue;
+		LocalBounds += Primitive->CalcBounds(Primitive->GetComponentTransform().GetRelativeTransform(ActorTransform)).GetBox();
+	}
+	return LocalBounds;
+}
+
+void AClimbableWall::OnClimbZoneBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	AWallClimbJumpCharacter* Character = Cast<AWallClimbJumpCharacter>(OtherActor);
+	if(!Character || OtherComp != Character->GetCapsuleComponent()) return;
+	Character->EnterWallZone(this);
+}
+
+void AClimbableWall::OnClimbZoneEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+{
+	AWallClimbJumpCharacter* Character = Cast<AWallClimbJumpCharacter>(OtherActor);
+	if(!Character || OtherComp != Character->GetCapsuleComponent()) return;
+	Character->ExitWallZone(this);
+}
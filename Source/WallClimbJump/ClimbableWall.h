@@ -15,4 +15,25 @@ public:
 	// Sets default values for this actor's properties
 	AClimbableWall();
 
+	/** How far the climb zone extends past the wall's collision on every side */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Climbing)
+	float ClimbZonePadding = 80.f;
+
+	/** World bounds of the wall's own collision, excluding the climb zone */
+	FBox GetWallBounds() const;
+
+protected:
+	virtual void BeginPlay() override;
+
+	FBox CalculateWallLocalBounds() const;
+
+	UFUNCTION()
+	void OnClimbZoneBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+	UFUNCTION()
+	void OnClimbZoneEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+
+	/** Characters only look for this wall while their capsule is inside this volume, created on BeginPlay */
+	UPROPERTY(VisibleInstanceOnly, Transient, BlueprintReadOnly, Category=Climbing)
+	class UBoxComponent* ClimbZone;
+
 };
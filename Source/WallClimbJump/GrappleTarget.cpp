@@ -8,8 +8,8 @@
 // Sets default values
 AGrappleTarget::AGrappleTarget()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Nothing to do per frame, the owning character moves the marker when the target changes
+	PrimaryActorTick.bCanEverTick = false;
 
 }
 
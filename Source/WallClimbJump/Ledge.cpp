@@ -2,7 +2,11 @@
 
 
 #include "Ledge.h"
+
+#include "WallClimbJumpCharacter.h"
 #include "Blueprint/WidgetLayoutLibrary.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
 #include "Kismet/GameplayStatics.h"
 
 // Sets default values
@@ -13,6 +17,163 @@ ALedge::ALedge()
 
 }
 
+void ALedge::BeginPlay()
+{
+	Super::BeginPlay();
+	BuildGrabSegment();
+	CreateHelperVolumes();
+	FitGrabVolume();
+	FitCollisionProxy();
+	if(ULedgeSubsystem* LedgeSubsystem = GetWorld()->GetSubsystem<ULedgeSubsystem>())
+	{
+		RegistryHandle = LedgeSubsystem->RegisterLedge(this);
+	}
+}
+
+void ALedge::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if(ULedgeSubsystem* LedgeSubsystem = GetWorld()->GetSubsystem<ULedgeSubsystem>())
+	{
+		LedgeSubsystem->UnregisterLedge(RegistryHandle);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void ALedge::BuildGrabSegment()
+{
+	bHasGrabSegment = false;
+	const FBox LocalBox = CalculateLedgeLocalBounds();
+	LedgeBounds = LocalBox.IsValid ? LocalBox.TransformBy(GetActorTransform()) : FBox(ForceInit);
+	if(bComplexGeometry || !LocalBox.IsValid) return;
+
+	// The edge runs along the longer horizontal axis across the middle of the top face
+	const FVector Center = LocalBox.GetCenter();
+	const FVector Extent = LocalBox.GetExtent();
+	const bool bAlongX = Extent.X >= Extent.Y;
+	const FVector EdgeAxis = bAlongX ? FVector(Extent.X, 0, 0) : FVector(0, Extent.Y, 0);
+	const FVector TopCenter(Center.X, Center.Y, LocalBox.Max.Z);
+
+	const FTransform& ActorTransform = GetActorTransform();
+	GrabSegment.Start = ActorTransform.TransformPosition(TopCenter - EdgeAxis);
+	GrabSegment.End = ActorTransform.TransformPosition(TopCenter + EdgeAxis);
+	GrabSegment.Normal = ActorTransform.TransformVectorNoScale(bAlongX ? FVector::RightVector : FVector::ForwardVector);
+	GrabSegment.HangHeight = FMath::Max(GrabSegment.Start.Z, GrabSegment.End.Z);
+	bHasGrabSegment = true;
+}
+
+void ALedge::CreateHelperVolumes()
+{
+	// Added under the blueprint's own root at runtime, a native root would displace placed ledges from their saved transforms
+	USceneComponent* Root = GetRootComponent();
+	if(!Root) return;
+
+	GrabVolume = NewObject<UBoxComponent>(this, TEXT("GrabVolume"));
+	GrabVolume->SetupAttachment(Root);
+	GrabVolume->SetUsingAbsoluteScale(true);
+	GrabVolume->SetCollisionProfileName(TEXT("Trigger"));
+	GrabVolume->SetCollisionResponseToChannel(ECC_GameTraceChannel1, ECR_Ignore);
+	GrabVolume->OnComponentBeginOverlap.AddDynamic(this, &ALedge::OnGrabVolumeBeginOverlap);
+	GrabVolume->OnComponentEndOverlap.AddDynamic(this, &ALedge::OnGrabVolumeEndOverlap);
+	GrabVolume->RegisterComponent();
+
+	CollisionProxy = NewObject<UBoxComponent>(this, TEXT("CollisionProxy"));
+	CollisionProxy->SetupAttachment(Root);
+	CollisionProxy->SetCollisionProfileName(TEXT("LedgeProxy"));
+	CollisionProxy->SetGenerateOverlapEvents(false);
+	CollisionProxy->SetCanEverAffectNavigation(false);
+	CollisionProxy->RegisterComponent();
+}
+
+void ALedge::FitGrabVolume()
+{
+	if(!GrabVolume) return;
+	if(!bUseGrabVolume || !LedgeBounds.IsValid)
+	{
+		GrabVolume->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		GrabVolume->SetGenerateOverlapEvents(false);
+		return;
+	}
+
+	// Box hangs under the edge, lined up with it when the edge is known
+	FVector Center;
+	FVector Extent;
+	FQuat Rotation = FQuat::Identity;
+	if(bHasGrabSegment)
+	{
+		Center = (GrabSegment.Start + GrabSegment.End) * 0.5f;
+		Extent = FVector(GrabSegment.GetLength() * 0.5f + GrabVolumeReach.X, GrabVolumeReach.Y, GrabVolumeReach.Z * 0.5f);
+		Rotation = FRotationMatrix::MakeFromX(GrabSegment.GetDirection()).ToQuat();
+		Center.Z = GrabSegment.HangHeight - Extent.Z;
+	}
+	else
+	{
+		Center = LedgeBounds.GetCenter();
+		Extent = LedgeBounds.GetExtent() + FVector(GrabVolumeReach.Y, GrabVolumeReach.Y, 0);
+		Extent.Z = GrabVolumeReach.Z * 0.5f;
+		Center.Z = LedgeBounds.Max.Z - Extent.Z;
+	}
+	GrabVolume->SetWorldLocationAndRotation(Center, Rotation);
+	GrabVolume->SetBoxExtent(Extent);
+}
+
+void ALedge::FitCollisionProxy()
+{
+	if(!CollisionProxy) return;
+	const FBox LocalBox = CalculateLedgeLocalBounds();
+	if(!LocalBox.IsValid)
+	{
+		CollisionProxy->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		return;
+	}
+
+	// Straight ledges only need the slab under the edge that hands and traces reach
+	FBox ProxyBox = LocalBox;
+	if(bHasGrabSegment)
+	{
+		const float Scale = FMath::Max(FMath::Abs(GetActorScale3D().Z), KINDA_SMALL_NUMBER);
+		ProxyBox.Min.Z = FMath::Max(LocalBox.Min.Z, LocalBox.Max.Z - CollisionProxyDepth / Scale);
+	}
+	CollisionProxy->SetRelativeLocation(ProxyBox.GetCenter());
+	CollisionProxy->SetBoxExtent(ProxyBox.GetExtent());
+}
+
+FBox ALedge::CalculateLedgeLocalBounds() const
+{
+	FBox LocalBounds(ForceInit);
+	const FTransform& ActorTransform = GetActorTransform();
+	for(UActorComponent* Component : GetComponents())
+	{
+		const UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+		if(!Primitive || Primitive == GrabVolume || Primitive == CollisionProxy || !Primitive->IsCollisionEnabled()) continue;
+		LocalBounds += Primitive->CalcBounds(Primitive->GetComponentTransform().GetRelativeTransform(ActorTransform)).GetBox();
+	}
+	return LocalBounds;
+}
+
+void ALedge::OnGrabVolumeBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	AWallClimbJumpCharacter* Character = Cast<AWallClimbJumpCharacter>(OtherActor);
+	if(!Character || OtherComp != Character->GetCapsuleComponent()) return;
+	Character->EnterLedgeVolume(this);
+}
+
+void ALedge::OnGrabVolumeEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+{
+	AWallClimbJumpCharacter* Character = Cast<AWallClimbJumpCharacter>(OtherActor);
+	if(!Character || OtherComp != Character->GetCapsuleComponent()) return;
+	Character->ExitLedgeVolume(this);
+}
+
+float ALedge::GetDistanceToGrabPoint(const FVector& Point, FVector& OutClosestPoint) const
+{
+	if(!bHasGrabSegment)
+	{
+		return ActorGetDistanceToCollision(Point, ECC_GameTraceChannel1, OutClosestPoint);
+	}
+	OutClosestPoint = GrabSegment.GetClosestPoint(Point);
+	return FVector::Dist(Point, OutClosestPoint);
+}
+
 bool ALedge::IsOnScreen(FVector PointLocation)
 {
 	FVector2D ScreenLocation;
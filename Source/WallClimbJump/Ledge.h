@@ -3,9 +3,26 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "LedgeSubsystem.h"
 #include "GameFramework/Actor.h"
 #include "Ledge.generated.h"
 
+/** Grabbable top edge of a ledge, precomputed once so queries reduce to segment math. */
+USTRUCT()
+struct FLedgeGrabSegment
+{
+	GENERATED_BODY()
+
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	FVector Normal = FVector::ForwardVector;
+	float HangHeight = 0.f;
+
+	FVector GetClosestPoint(const FVector& Point) const { return FMath::ClosestPointOnSegment(Point, Start, End); }
+	FVector GetDirection() const { return (End - Start).GetSafeNormal(); }
+	float GetLength() const { return FVector::Dist(Start, End); }
+};
+
 UCLASS()
 class WALLCLIMBJUMP_API ALedge : public AActor
 {
@@ -17,9 +34,59 @@ public:
 	UFUNCTION()
 	bool IsOnScreen(FVector PointLocation);
 
+	/** Distance from Point to the grabbable edge, returns 0 or less if there is no valid point like ActorGetDistanceToCollision */
+	float GetDistanceToGrabPoint(const FVector& Point, FVector& OutClosestPoint) const;
+	const FLedgeGrabSegment& GetGrabSegment() const { return GrabSegment; }
+	bool HasGrabSegment() const { return bHasGrabSegment; }
+	/** World bounds of the ledge's own collision, excluding helper volumes */
+	const FBox& GetLedgeBounds() const { return LedgeBounds; }
+	bool UsesGrabVolume() const { return bUseGrabVolume; }
+	const FLedgeHandle& GetRegistryHandle() const { return RegistryHandle; }
+	/** Recomputes the bounds and grab segment from the ledge's collision, done on BeginPlay */
+	void BuildGrabSegment();
+
+	/** Use full collision queries instead of the precomputed edge, for ledges that aren't a straight box */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Ledge)
+	bool bComplexGeometry = false;
+
+	/** Let characters find this ledge by overlapping GrabVolume instead of sweeping for it every frame */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Ledge)
+	bool bUseGrabVolume = true;
+
+	/** How far the grab volume reaches below the edge and out from it on either side */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Ledge)
+	FVector GrabVolumeReach = FVector(60.f, 100.f, 260.f);
+
+	/** How far below the top the collision proxy reaches, complex ledges get a proxy over their whole bounds */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Ledge)
+	float CollisionProxyDepth = 60.f;
+
 protected:
 	// Called when the game starts or when spawned
-	// virtual void BeginPlay() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void CreateHelperVolumes();
+	void FitGrabVolume();
+	void FitCollisionProxy();
+	FBox CalculateLedgeLocalBounds() const;
+
+	UFUNCTION()
+	void OnGrabVolumeBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+	UFUNCTION()
+	void OnGrabVolumeEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+
+	/** Space below the edge from which a character can jump up and grab it, created on BeginPlay */
+	UPROPERTY(VisibleInstanceOnly, Transient, BlueprintReadOnly, Category=Ledge)
+	class UBoxComponent* GrabVolume;
+	/** Box standing in for the ledge's collision in traversal queries, the only thing of the Ledge object type */
+	UPROPERTY(VisibleInstanceOnly, Transient, BlueprintReadOnly, Category=Ledge)
+	UBoxComponent* CollisionProxy;
+
+	FLedgeHandle RegistryHandle;
+	FBox LedgeBounds;
+	FLedgeGrabSegment GrabSegment;
+	bool bHasGrabSegment = false;
 
 public:	
 	// Called every frame
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LedgeSpatialGrid.h"
+
+#include "Ledge.h"
+
+FLedgeSpatialGrid::FLedgeSpatialGrid(const float InCellSize)
+	: CellSize(FMath::Max(InCellSize, 1.f))
+{
+}
+
+void FLedgeSpatialGrid::Reset()
+{
+	Cells.Reset();
+	Entries.Reset();
+	EntryBounds.Reset();
+	EntryOrder.Reset();
+	OccupiedBounds = FBox(ForceInit);
+	VisitStamps.Reset();
+	CurrentStamp = 0;
+}
+
+void FLedgeSpatialGrid::Add(const int32 Id, ALedge* Ledge, const uint32 Order)
+{
+	if(!Ledge || Id < 0) return;
+	const FBox Bounds = Ledge->GetLedgeBounds();
+	if(!Bounds.IsValid) return;
+
+	if(Id >= Entries.Num())
+	{
+		Entries.SetNumZeroed(Id + 1);
+		EntryBounds.SetNumZeroed(Id + 1);
+		EntryOrder.SetNumZeroed(Id + 1);
+		VisitStamps.SetNumZeroed(Id + 1);
+	}
+	Entries[Id] = Ledge;
+	EntryBounds[Id] = Bounds;
+	EntryOrder[Id] = Order;
+	OccupiedBounds += Bounds;
+
+	const FIntPoint MinCell = ToCell(Bounds.Min);
+	const FIntPoint MaxCell = ToCell(Bounds.Max);
+	for(int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for(int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			Cells.FindOrAdd(FIntPoint(X, Y)).Add(Id);
+		}
+	}
+}
+
+void FLedgeSpatialGrid::Remove(const int32 Id)
+{
+	if(!Entries.IsValidIndex(Id) || !Entries[Id]) return;
+
+	const FBox& Bounds = EntryBounds[Id];
+	const FIntPoint MinCell = ToCell(Bounds.Min);
+	const FIntPoint MaxCell = ToCell(Bounds.Max);
+	for(int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for(int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const FIntPoint Key(X, Y);
+			TArray<int32>* Cell = Cells.Find(Key);
+			if(!Cell) continue;
+			Cell->RemoveSingleSwap(Id, false);
+			if(Cell->Num() == 0)
+			{
+				Cells.Remove(Key);
+			}
+		}
+	}
+	Entries[Id] = nullptr;
+	EntryBounds[Id] = FBox(ForceInit);
+}
+
+void FLedgeSpatialGrid::QuerySphere(const FVector& Center, const float Radius, TArray<ALedge*>& OutLedges) const
+{
+	OutLedges.Reset();
+	if(Entries.Num() == 0) return;
+
+	if(++CurrentStamp == 0)
+	{
+		// Stamp wrapped around, clear so stale stamps can't collide with the new one
+		FMemory::Memzero(VisitStamps.GetData(), VisitStamps.Num() * sizeof(uint32));
+		CurrentStamp = 1;
+	}
+
+	ScratchIndices.Reset();
+	const float RadiusSquared = Radius * Radius;
+	const FIntPoint MinCell = ToCell(FVector::Max(Center - FVector(Radius), OccupiedBounds.Min));
+	const FIntPoint MaxCell = ToCell(FVector::Min(Center + FVector(Radius), OccupiedBounds.Max));
+	for(int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for(int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y));
+			if(!Cell) continue;
+			for(const int32 Index : *Cell)
+			{
+				if(VisitStamps[Index] == CurrentStamp) continue;
+				VisitStamps[Index] = CurrentStamp;
+				if(EntryBounds[Index].ComputeSquaredDistanceToPoint(Center) > RadiusSquared) continue;
+				ScratchIndices.Add(Index);
+			}
+		}
+	}
+
+	// Ids get reused, so sort by the order key to keep ties resolving the same way as a linear scan
+	ScratchIndices.Sort([this](const int32 A, const int32 B) { return EntryOrder[A] < EntryOrder[B]; });
+	for(const int32 Index : ScratchIndices)
+	{
+		ALedge* Ledge = Entries[Index];
+		if(IsValid(Ledge))
+		{
+			OutLedges.Add(Ledge);
+		}
+	}
+}
+
+FIntPoint FLedgeSpatialGrid::ToCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ALedge;
+
+/**
+ * Uniform grid over the XY plane, bucketing ledges by their world bounds so
+ * range queries only visit ledges in nearby cells. Entries are keyed by a
+ * caller supplied id so they can be added and removed incrementally, and
+ * carry an order key so query results don't depend on which ids get reused.
+ */
+class WALLCLIMBJUMP_API FLedgeSpatialGrid
+{
+public:
+	explicit FLedgeSpatialGrid(float InCellSize = 1000.f);
+
+	void Add(int32 Id, ALedge* Ledge, uint32 Order);
+	void Remove(int32 Id);
+	void Reset();
+
+	/** Collects ledges whose bounds lie within Radius of Center, ordered by their order key. Radius can be unbounded. */
+	void QuerySphere(const FVector& Center, float Radius, TArray<ALedge*>& OutLedges) const;
+
+private:
+	FIntPoint ToCell(const FVector& Location) const;
+
+	float CellSize;
+	TMap<FIntPoint, TArray<int32>> Cells;
+	TArray<ALedge*> Entries;
+	TArray<FBox> EntryBounds;
+	TArray<uint32> EntryOrder;
+	/** Everything ever added since the last reset, queries never walk cells outside it */
+	FBox OccupiedBounds = FBox(ForceInit);
+
+	// Per-entry stamp used to skip ledges already visited through another cell
+	mutable TArray<uint32> VisitStamps;
+	mutable uint32 CurrentStamp = 0;
+	mutable TArray<int32> ScratchIndices;
+};
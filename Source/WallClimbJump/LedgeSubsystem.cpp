@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LedgeSubsystem.h"
+
+#include "Ledge.h"
+#include "WallClimbJump.h"
+
+namespace LedgeLinks
+{
+	/** How far apart two edge ends can be and still count as one continuous edge */
+	constexpr float JoinTolerance = 30.f;
+	/** Edges must be this close to parallel to join */
+	constexpr float MinJoinAlignment = 0.95f;
+	/** Upper bound on ledges crossed by a single span lookup */
+	constexpr int32 MaxSpanHops = 8;
+}
+
+void ULedgeSubsystem::Deinitialize()
+{
+	Ledges.Reset();
+	DenseToSlot.Reset();
+	Slots.Reset();
+	FreeSlots.Reset();
+	Links.Reset();
+	Grid.Reset();
+	LedgesWithoutGrabVolume = 0;
+	Super::Deinitialize();
+}
+
+FLedgeHandle ULedgeSubsystem::RegisterLedge(ALedge* Ledge)
+{
+	LLM_SCOPE_BYTAG(Traversal);
+	FLedgeHandle Handle;
+	if(!Ledge) return Handle;
+
+	const int32 Slot = FreeSlots.Num() > 0 ? FreeSlots.Pop(false) : Slots.AddDefaulted();
+	FSlot& SlotData = Slots[Slot];
+	SlotData.DenseIndex = Ledges.Add(Ledge);
+	SlotData.Serial = NextSerial++;
+	DenseToSlot.Add(Slot);
+
+	Handle.Slot = Slot;
+	Handle.Serial = SlotData.Serial;
+	Grid.Add(Slot, Ledge, Handle.Serial);
+	LinkLedge(Ledge, Handle);
+	if(!Ledge->UsesGrabVolume())
+	{
+		++LedgesWithoutGrabVolume;
+	}
+	OnLedgeAdded.Broadcast(Ledge, Handle);
+	return Handle;
+}
+
+void ULedgeSubsystem::UnregisterLedge(FLedgeHandle& Handle)
+{
+	ALedge* Ledge = Resolve(Handle);
+	if(!Ledge)
+	{
+		Handle.Invalidate();
+		return;
+	}
+
+	OnLedgeRemoved.Broadcast(Ledge, Handle);
+	Grid.Remove(Handle.Slot);
+	UnlinkLedge(Handle);
+	if(!Ledge->UsesGrabVolume())
+	{
+		--LedgesWithoutGrabVolume;
+	}
+
+	// Swap the last ledge into the hole and repoint its slot
+	FSlot& SlotData = Slots[Handle.Slot];
+	const int32 DenseIndex = SlotData.DenseIndex;
+	const int32 LastIndex = Ledges.Num() - 1;
+	if(DenseIndex != LastIndex)
+	{
+		Slots[DenseToSlot[LastIndex]].DenseIndex = DenseIndex;
+	}
+	Ledges.RemoveAtSwap(DenseIndex, 1, false);
+	DenseToSlot.RemoveAtSwap(DenseIndex, 1, false);
+
+	SlotData.DenseIndex = INDEX_NONE;
+	SlotData.Serial = 0;
+	FreeSlots.Add(Handle.Slot);
+	Handle.Invalidate();
+}
+
+ALedge* ULedgeSubsystem::Resolve(const FLedgeHandle& Handle) const
+{
+	if(!Slots.IsValidIndex(Handle.Slot)) return nullptr;
+	const FSlot& SlotData = Slots[Handle.Slot];
+	if(SlotData.Serial != Handle.Serial || SlotData.DenseIndex == INDEX_NONE) return nullptr;
+	return Ledges[SlotData.DenseIndex];
+}
+
+void ULedgeSubsystem::QuerySphere(const FVector& Center, const float Radius, TArray<ALedge*>& OutLedges) const
+{
+	Grid.QuerySphere(Center, Radius, OutLedges);
+}
+
+ALedge* ULedgeSubsystem::FindLedgeAlongSpan(const ALedge* Ledge, const FVector& Point, const float Distance) const
+{
+	if(!Ledge || !Ledge->HasGrabSegment()) return nullptr;
+	const FLedgeGrabSegment& Segment = Ledge->GetGrabSegment();
+	const float Length = Segment.GetLength();
+	const float Along = FVector::DotProduct(Point - Segment.Start, Segment.GetDirection()) + Distance;
+	if(Along >= 0.f && Along <= Length) return const_cast<ALedge*>(Ledge);
+
+	// Walk the links off whichever end the point went past, carrying the leftover distance
+	int32 ExitEnd = Along > Length ? 1 : 0;
+	float Overshoot = ExitEnd ? Along - Length : -Along;
+	FLedgeHandle Current = Ledge->GetRegistryHandle();
+	for(int32 Hop = 0; Hop < LedgeLinks::MaxSpanHops; ++Hop)
+	{
+		if(!Links.IsValidIndex(Current.Slot)) return nullptr;
+		const FLedgeHandle Next = Links[Current.Slot].Ends[ExitEnd];
+		ALedge* NextLedge = Resolve(Next);
+		if(!NextLedge) return nullptr;
+		const float NextLength = NextLedge->GetGrabSegment().GetLength();
+		if(Overshoot <= NextLength) return NextLedge;
+		Overshoot -= NextLength;
+		ExitEnd = Links[Next.Slot].Ends[0] == Current ? 1 : 0;
+		Current = Next;
+	}
+	return nullptr;
+}
+
+int32 ULedgeSubsystem::FindJoinedEnd(const FLedgeGrabSegment& Segment, const int32 End, const FLedgeGrabSegment& Other)
+{
+	if(FMath::Abs(FVector::DotProduct(Segment.GetDirection(), Other.GetDirection())) < LedgeLinks::MinJoinAlignment) return INDEX_NONE;
+	const FVector& Point = End ? Segment.End : Segment.Start;
+	if(FVector::Dist(Point, Other.Start) <= LedgeLinks::JoinTolerance) return 0;
+	if(FVector::Dist(Point, Other.End) <= LedgeLinks::JoinTolerance) return 1;
+	return INDEX_NONE;
+}
+
+void ULedgeSubsystem::LinkLedge(ALedge* Ledge, const FLedgeHandle& Handle)
+{
+	if(Links.Num() < Slots.Num())
+	{
+		Links.SetNum(Slots.Num());
+	}
+	Links[Handle.Slot] = FLedgeLinks();
+	if(!Ledge->HasGrabSegment()) return;
+
+	const FLedgeGrabSegment& Segment = Ledge->GetGrabSegment();
+	TArray<ALedge*> Candidates;
+	for(int32 End = 0; End < 2; ++End)
+	{
+		Grid.QuerySphere(End ? Segment.End : Segment.Start, LedgeLinks::JoinTolerance, Candidates);
+		for(ALedge* Candidate : Candidates)
+		{
+			if(Candidate == Ledge || !Candidate->HasGrabSegment()) continue;
+			const int32 OtherEnd = FindJoinedEnd(Segment, End, Candidate->GetGrabSegment());
+			const FLedgeHandle& OtherHandle = Candidate->GetRegistryHandle();
+			if(OtherEnd == INDEX_NONE || !Links.IsValidIndex(OtherHandle.Slot) || Resolve(OtherHandle) != Candidate) continue;
+			// Links stay two way, an end already joined to a live ledge keeps its neighbour
+			if(Resolve(Links[OtherHandle.Slot].Ends[OtherEnd])) continue;
+			Links[Handle.Slot].Ends[End] = OtherHandle;
+			Links[OtherHandle.Slot].Ends[OtherEnd] = Handle;
+			break;
+		}
+	}
+}
+
+void ULedgeSubsystem::UnlinkLedge(const FLedgeHandle& Handle)
+{
+	if(!Links.IsValidIndex(Handle.Slot)) return;
+	for(const FLedgeHandle& Neighbour : Links[Handle.Slot].Ends)
+	{
+		if(!Resolve(Neighbour)) continue;
+		for(FLedgeHandle& BackLink : Links[Neighbour.Slot].Ends)
+		{
+			if(BackLink == Handle)
+			{
+				BackLink.Invalidate();
+			}
+		}
+	}
+	Links[Handle.Slot] = FLedgeLinks();
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LedgeSpatialGrid.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LedgeSubsystem.generated.h"
+
+class ALedge;
+
+/** Stable reference to a registered ledge, stays valid while the ledge is registered. */
+USTRUCT()
+struct FLedgeHandle
+{
+	GENERATED_BODY()
+
+	int32 Slot = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Slot != INDEX_NONE; }
+	void Invalidate() { Slot = INDEX_NONE; Serial = 0; }
+	bool operator==(const FLedgeHandle& Other) const { return Slot == Other.Slot && Serial == Other.Serial; }
+};
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnLedgeRegistryChanged, ALedge*, FLedgeHandle);
+
+/**
+ * World-wide registry of ledges. Ledges add themselves on BeginPlay and remove
+ * themselves on EndPlay, so streamed sublevels are picked up and released as
+ * they load and unload. Ledges are kept in a dense array for iteration, with
+ * handles resolving through a slot table so they survive removals.
+ */
+UCLASS()
+class WALLCLIMBJUMP_API ULedgeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	FLedgeHandle RegisterLedge(ALedge* Ledge);
+	void UnregisterLedge(FLedgeHandle& Handle);
+
+	ALedge* Resolve(const FLedgeHandle& Handle) const;
+	const TArray<ALedge*>& GetLedges() const { return Ledges; }
+	int32 Num() const { return Ledges.Num(); }
+	/** Ledges that can only be found by sweeping, so characters can't rely on grab volumes alone */
+	int32 NumWithoutGrabVolume() const { return LedgesWithoutGrabVolume; }
+
+	/** Collects registered ledges whose bounds lie within Radius of Center. */
+	void QuerySphere(const FVector& Center, float Radius, TArray<ALedge*>& OutLedges) const;
+
+	/**
+	 * Ledge under the point Distance along Ledge's grab segment from Point, following links onto the
+	 * ledges its edge continues into. Null once the span runs out in that direction.
+	 */
+	ALedge* FindLedgeAlongSpan(const ALedge* Ledge, const FVector& Point, float Distance) const;
+	/** Which end of Other (0 start, 1 end) continues Segment past the given end, INDEX_NONE if the edges don't join */
+	static int32 FindJoinedEnd(const struct FLedgeGrabSegment& Segment, int32 End, const FLedgeGrabSegment& Other);
+
+	UFUNCTION(BlueprintCallable, Category="Ledges", meta=(DisplayName="Get Registered Ledges"))
+	TArray<ALedge*> GetRegisteredLedges() const { return Ledges; }
+
+	FOnLedgeRegistryChanged OnLedgeAdded;
+	FOnLedgeRegistryChanged OnLedgeRemoved;
+
+private:
+	struct FSlot
+	{
+		int32 DenseIndex = INDEX_NONE;
+		uint32 Serial = 0;
+	};
+
+	/** Neighbours continuing the grab segment past its start and end */
+	struct FLedgeLinks
+	{
+		FLedgeHandle Ends[2];
+	};
+
+	void LinkLedge(ALedge* Ledge, const FLedgeHandle& Handle);
+	void UnlinkLedge(const FLedgeHandle& Handle);
+
+	UPROPERTY()
+	TArray<ALedge*> Ledges;
+	TArray<int32> DenseToSlot;
+	TArray<FSlot> Slots;
+	TArray<int32> FreeSlots;
+	/** Indexed by slot like Slots */
+	TArray<FLedgeLinks> Links;
+	uint32 NextSerial = 1;
+	int32 LedgesWithoutGrabVolume = 0;
+	FLedgeSpatialGrid Grid;
+};
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LedgeVisibility.h"
+
+#include "SceneView.h"
+#include "Engine/GameViewportClient.h"
+#include "Camera/CameraTypes.h"
+#include "Engine/LocalPlayer.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+
+bool FLedgeScreenView::Capture(const APlayerController* PlayerController)
+{
+	if(!PlayerController) return false;
+	ULocalPlayer* LocalPlayer = PlayerController->GetLocalPlayer();
+	if(!LocalPlayer || !LocalPlayer->ViewportClient) return false;
+
+	FSceneViewProjectionData ProjectionData;
+	if(!LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, eSSP_FULL, ProjectionData)) return false;
+
+	ViewProjection = ProjectionData.ComputeViewProjectionMatrix();
+	ViewRect = ProjectionData.GetConstrainedViewRect();
+	LocalPlayer->ViewportClient->GetViewportSize(ViewportSize);
+	return true;
+}
+
+bool FLedgeScreenView::Capture(const FMinimalViewInfo& ViewInfo, const FIntPoint& InViewportSize)
+{
+	if(InViewportSize.X <= 0 || InViewportSize.Y <= 0) return false;
+
+	FMinimalViewInfo ViewportView = ViewInfo;
+	ViewportView.AspectRatio = static_cast<float>(InViewportSize.X) / InViewportSize.Y;
+	FMatrix ViewMatrix;
+	FMatrix ProjectionMatrix;
+	UGameplayStatics::GetViewProjectionMatrix(ViewportView, ViewMatrix, ProjectionMatrix, ViewProjection);
+	ViewRect = FIntRect(FIntPoint::ZeroValue, InViewportSize);
+	ViewportSize = FVector2D(InViewportSize);
+	return true;
+}
+
+void FLedgeVisibilityBatch::Reset()
+{
+	X.Reset();
+	Y.Reset();
+	Z.Reset();
+	NumPoints = 0;
+}
+
+int32 FLedgeVisibilityBatch::Add(const FVector& Point)
+{
+	// Grow a whole register at a time so Compute never reads past the end
+	if(NumPoints == X.Num())
+	{
+		X.AddZeroed(4);
+		Y.AddZeroed(4);
+		Z.AddZeroed(4);
+	}
+	X[NumPoints] = Point.X;
+	Y[NumPoints] = Point.Y;
+	Z[NumPoints] = Point.Z;
+	return NumPoints++;
+}
+
+void FLedgeVisibilityBatch::Compute(const FLedgeScreenView& View, TBitArray<>& OutVisible) const
+{
+	OutVisible.Init(false, NumPoints);
+	if(NumPoints == 0) return;
+
+	const int32 NumPadded = Align(NumPoints, 4);
+
+	const FMatrix& M = View.ViewProjection;
+	const VectorRegister M00 = VectorSetFloat1(M.M[0][0]), M10 = VectorSetFloat1(M.M[1][0]), M20 = VectorSetFloat1(M.M[2][0]), M30 = VectorSetFloat1(M.M[3][0]);
+	const VectorRegister M01 = VectorSetFloat1(M.M[0][1]), M11 = VectorSetFloat1(M.M[1][1]), M21 = VectorSetFloat1(M.M[2][1]), M31 = VectorSetFloat1(M.M[3][1]);
+	const VectorRegister M03 = VectorSetFloat1(M.M[0][3]), M13 = VectorSetFloat1(M.M[1][3]), M23 = VectorSetFloat1(M.M[2][3]), M33 = VectorSetFloat1(M.M[3][3]);
+
+	// Screen = (Clip / W * (0.5, -0.5) + 0.5) * RectSize + RectMin, matching FSceneView::ProjectWorldToScreen
+	const VectorRegister Half = VectorSetFloat1(0.5f);
+	const VectorRegister NegHalf = VectorSetFloat1(-0.5f);
+	const VectorRegister RectWidth = VectorSetFloat1(View.ViewRect.Width());
+	const VectorRegister RectHeight = VectorSetFloat1(View.ViewRect.Height());
+	const VectorRegister RectMinX = VectorSetFloat1(View.ViewRect.Min.X);
+	const VectorRegister RectMinY = VectorSetFloat1(View.ViewRect.Min.Y);
+	const VectorRegister MaxX = VectorSetFloat1(View.ViewportSize.X);
+	const VectorRegister MaxY = VectorSetFloat1(View.ViewportSize.Y);
+	const VectorRegister Zero = VectorZero();
+
+	for(int32 Base = 0; Base < NumPadded; Base += 4)
+	{
+		const VectorRegister PX = VectorLoad(&X[Base]);
+		const VectorRegister PY = VectorLoad(&Y[Base]);
+		const VectorRegister PZ = VectorLoad(&Z[Base]);
+
+		const VectorRegister ClipX = VectorMultiplyAdd(PX, M00, VectorMultiplyAdd(PY, M10, VectorMultiplyAdd(PZ, M20, M30)));
+		const VectorRegister ClipY = VectorMultiplyAdd(PX, M01, VectorMultiplyAdd(PY, M11, VectorMultiplyAdd(PZ, M21, M31)));
+		const VectorRegister ClipW = VectorMultiplyAdd(PX, M03, VectorMultiplyAdd(PY, M13, VectorMultiplyAdd(PZ, M23, M33)));
+
+		const VectorRegister InFront = VectorCompareGT(ClipW, Zero);
+		// Avoid dividing by zero for points behind the camera, they are masked out anyway
+		const VectorRegister SafeW = VectorSelect(InFront, ClipW, VectorOne());
+
+		const VectorRegister NdcX = VectorDivide(ClipX, SafeW);
+		const VectorRegister NdcY = VectorDivide(ClipY, SafeW);
+		const VectorRegister ScreenX = VectorMultiplyAdd(VectorMultiplyAdd(NdcX, Half, Half), RectWidth, RectMinX);
+		const VectorRegister ScreenY = VectorMultiplyAdd(VectorMultiplyAdd(NdcY, NegHalf, Half), RectHeight, RectMinY);
+
+		VectorRegister Inside = VectorBitwiseAnd(InFront, VectorCompareGE(ScreenX, Zero));
+		Inside = VectorBitwiseAnd(Inside, VectorCompareGE(ScreenY, Zero));
+		Inside = VectorBitwiseAnd(Inside, VectorCompareLE(ScreenX, MaxX));
+		Inside = VectorBitwiseAnd(Inside, VectorCompareLE(ScreenY, MaxY));
+
+		const int32 Mask = VectorMaskBits(Inside);
+		for(int32 Lane = 0; Lane < 4 && Base + Lane < NumPoints; ++Lane)
+		{
+			if(Mask & (1 << Lane))
+			{
+				OutVisible[Base + Lane] = true;
+			}
+		}
+	}
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class APlayerController;
+struct FMinimalViewInfo;
+
+/** Camera data needed to project points to the screen, captured once per frame. */
+struct FLedgeScreenView
+{
+	FMatrix ViewProjection = FMatrix::Identity;
+	FIntRect ViewRect;
+	FVector2D ViewportSize = FVector2D::ZeroVector;
+
+	/** Fills the view from the player's local viewport, returns false if the player has no view. */
+	bool Capture(const APlayerController* PlayerController);
+	/** Fills the view from a camera as if it filled a viewport of the given size, for when there is no player viewport. */
+	bool Capture(const FMinimalViewInfo& ViewInfo, const FIntPoint& InViewportSize);
+};
+
+/**
+ * Structure-of-arrays buffer of world points that are projected and tested
+ * against the viewport four at a time.
+ */
+class WALLCLIMBJUMP_API FLedgeVisibilityBatch
+{
+public:
+	void Reset();
+	int32 Add(const FVector& Point);
+	int32 Num() const { return NumPoints; }
+
+	/** Sets bit N of OutVisible when point N projects inside the viewport and in front of the camera. */
+	void Compute(const FLedgeScreenView& View, TBitArray<>& OutVisible) const;
+
+private:
+	TArray<float> X;
+	TArray<float> Y;
+	TArray<float> Z;
+	int32 NumPoints = 0;
+};
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ClimbMovementComponent.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGrappleTrajectoryTest, "WallClimbJump.Traversal.GrappleTrajectory",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FGrappleTrajectoryTest::RunTest(const FString& Parameters)
+{
+	const FVector Start(0.f, 0.f, 100.f);
+	const FVector End(1000.f, 500.f, 400.f);
+	FGrappleTrajectory Trajectory;
+	Trajectory.Init(Start, End, 2.f, 80.f);
+	TestEqual(TEXT("Starts at the launch point"), Trajectory.Evaluate(), Start);
+	TestFalse(TEXT("Not complete before advancing"), Trajectory.IsComplete());
+
+	// Eased time is a half at the midpoint, where a quadratic Bezier is halfway up the arc
+	Trajectory.Advance(1.f);
+	TestEqual(TEXT("Halfway along, raised by half the arc height"), Trajectory.Evaluate(), (Start + End) * 0.5f + FVector(0.f, 0.f, 40.f), KINDA_SMALL_NUMBER);
+	TestEqual(TEXT("Time remaining"), Trajectory.GetTimeRemaining(), 1.f);
+
+	Trajectory.Advance(5.f);
+	TestTrue(TEXT("Complete once the duration has passed"), Trajectory.IsComplete());
+	TestEqual(TEXT("Advancing past the end clamps to the duration"), Trajectory.Elapsed, 2.f);
+	TestEqual(TEXT("Ends at the destination"), Trajectory.Evaluate(), End, KINDA_SMALL_NUMBER);
+
+	Trajectory.Init(Start, End, 0.f, 0.f);
+	TestEqual(TEXT("A zero length pull is already at the destination"), Trajectory.Evaluate(), End);
+	return true;
+}
+
+#endif
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LedgeSpatialGrid.h"
+#include "TraversalTestWorld.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLedgeSpatialGridQueryTest, "WallClimbJump.Traversal.LedgeSpatialGrid.Query",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLedgeSpatialGridQueryTest::RunTest(const FString& Parameters)
+{
+	FTraversalTestWorld TestWorld;
+	ALedge* Near = TestWorld.SpawnLedge(FVector(200.f, 0.f, 0.f));
+	ALedge* Far = TestWorld.SpawnLedge(FVector(5000.f, 0.f, 0.f));
+	// Long enough to cover several cells, it still has to come back once
+	ALedge* Wide = TestWorld.SpawnLedge(FVector(0.f, 600.f, 0.f), FVector(1500.f, 20.f, 20.f));
+
+	FLedgeSpatialGrid Grid(500.f);
+	Grid.Add(0, Near, 0);
+	Grid.Add(1, Far, 1);
+	Grid.Add(2, Wide, 2);
+
+	TArray<ALedge*> Result;
+	Grid.QuerySphere(FVector::ZeroVector, 1000.f, Result);
+	TestEqual(TEXT("Ledges within the radius"), Result, TArray<ALedge*>({Near, Wide}));
+
+	Grid.QuerySphere(FVector::ZeroVector, TNumericLimits<float>::Max(), Result);
+	TestEqual(TEXT("An unbounded radius returns every ledge"), Result, TArray<ALedge*>({Near, Far, Wide}));
+
+	Grid.QuerySphere(FVector(5000.f, 0.f, 0.f), 50.f, Result);
+	TestEqual(TEXT("A small radius only returns the ledge under it"), Result, TArray<ALedge*>({Far}));
+
+	Grid.Remove(0);
+	Grid.QuerySphere(FVector::ZeroVector, 1000.f, Result);
+	TestEqual(TEXT("Removed ledges are not returned"), Result, TArray<ALedge*>({Wide}));
+
+	Grid.Reset();
+	Grid.QuerySphere(FVector::ZeroVector, TNumericLimits<float>::Max(), Result);
+	TestEqual(TEXT("A reset grid is empty"), Result.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLedgeSpatialGridOrderTest, "WallClimbJump.Traversal.LedgeSpatialGrid.Order",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLedgeSpatialGridOrderTest::RunTest(const FString& Parameters)
+{
+	FTraversalTestWorld TestWorld;
+	ALedge* First = TestWorld.SpawnLedge(FVector(0.f, 0.f, 0.f));
+	ALedge* Second = TestWorld.SpawnLedge(FVector(3000.f, 0.f, 0.f));
+	ALedge* Third = TestWorld.SpawnLedge(FVector(-3000.f, 0.f, 0.f));
+
+	// Ids and cells don't follow the order keys, results still do
+	FLedgeSpatialGrid Grid(500.f);
+	Grid.Add(7, Third, 30);
+	Grid.Add(2, First, 10);
+	Grid.Add(4, Second, 20);
+
+	TArray<ALedge*> Result;
+	Grid.QuerySphere(FVector::ZeroVector, TNumericLimits<float>::Max(), Result);
+	TestEqual(TEXT("Results follow the order key"), Result, TArray<ALedge*>({First, Second, Third}));
+
+	// Reusing a freed id for a later entry puts it last
+	Grid.Remove(2);
+	Grid.Add(2, First, 40);
+	Grid.QuerySphere(FVector::ZeroVector, TNumericLimits<float>::Max(), Result);
+	TestEqual(TEXT("A reused id sorts by its new order key"), Result, TArray<ALedge*>({Second, Third, First}));
+	return true;
+}
+
+#endif
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LedgeSubsystem.h"
+#include "TraversalTestWorld.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLedgeSubsystemHandleTest, "WallClimbJump.Traversal.LedgeSubsystem.Handles",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FLedgeSubsystemHandleTest::RunTest(const FString& Parameters)
+{
+	FTraversalTestWorld TestWorld;
+	ULedgeSubsystem* Registry = TestWorld.World->GetSubsystem<ULedgeSubsystem>();
+	if(!TestNotNull(TEXT("Ledge subsystem"), Registry)) return false;
+
+	ALedge* A = TestWorld.SpawnLedge(FVector(0.f, 0.f, 0.f));
+	ALedge* B = TestWorld.SpawnLedge(FVector(1000.f, 0.f, 0.f));
+	ALedge* C = TestWorld.SpawnLedge(FVector(2000.f, 0.f, 0.f));
+
+	FLedgeHandle HandleA = Registry->RegisterLedge(A);
+	const FLedgeHandle HandleB = Registry->RegisterLedge(B);
+	TestTrue(TEXT("Handles resolve to their ledges"), Registry->Resolve(HandleA) == A && Registry->Resolve(HandleB) == B);
+	TestNotEqual(TEXT("Serials are unique"), HandleA.Serial, HandleB.Serial);
+
+	const FLedgeHandle StaleA = HandleA;
+	Registry->UnregisterLedge(HandleA);
+	TestFalse(TEXT("Unregistering invalidates the handle passed in"), HandleA.IsValid());
+	TestNull(TEXT("Stale handles resolve to nothing"), Registry->Resolve(StaleA));
+	TestTrue(TEXT("Other handles survive the removal"), Registry->Resolve(HandleB) == B);
+
+	const FLedgeHandle HandleC = Registry->RegisterLedge(C);
+	TestEqual(TEXT("Freed slots are reused"), HandleC.Slot, StaleA.Slot);
+	TestTrue(TEXT("A reused slot gets a later serial"), HandleC.Serial > HandleB.Serial);
+	TestNull(TEXT("A stale handle doesn't resolve to the slot's new ledge"), Registry->Resolve(StaleA));
+	TestTrue(TEXT("The new handle resolves"), Registry->Resolve(HandleC) == C);
+
+	// C took A's slot, queries still list ledges in registration order
+	TArray<ALedge*> Result;
+	Registry->QuerySphere(FVector::ZeroVector, TNumericLimits<float>::Max(), Result);
+	TestEqual(TEXT("Queries follow registration order"), Result, TArray<ALedge*>({B, C}));
+	TestEqual(TEXT("Registered ledges"), Registry->Num(), 2);
+	return true;
+}
+
+#endif
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TraversalBenchmarkCommandlet.h"
+#include "Dom/JsonObject.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTraversalAllocationTest, "WallClimbJump.Traversal.SteadyStateAllocations",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FTraversalAllocationTest::RunTest(const FString& Parameters)
+{
+	// The script jumps, grapples and fires the cable, so reaching both modes means those input paths were counted
+	const TSharedPtr<FJsonObject> Run = GetDefault<UTraversalBenchmarkCommandlet>()->RunAllocationCheck(100);
+	if(!TestNotNull(TEXT("Benchmark scenario"), Run.Get())) return false;
+	TestTrue(TEXT("Script reached hanging"), Run->GetBoolField(TEXT("reached_hang")));
+	TestTrue(TEXT("Script reached grappling"), Run->GetBoolField(TEXT("reached_grapple")));
+	TestEqual(TEXT("Allocations on the traversal hot path once the script loops"), static_cast<int32>(Run->GetNumberField(TEXT("steady_state_allocations"))), 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WallClimbJumpCharacter.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace TraversalRepStateTest
+{
+	/** Writes State and reads it back, the states used here don't send a ledge so no package map is needed */
+	FTraversalRepState RoundTrip(FTraversalRepState State, int64& OutNumBits)
+	{
+		bool bSuccess = false;
+		FBitWriter Writer(256, true);
+		State.NetSerialize(Writer, nullptr, bSuccess);
+		OutNumBits = Writer.GetNumBits();
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		FTraversalRepState Read;
+		Read.GrappleDuration = 5.f;
+		Read.NetSerialize(Reader, nullptr, bSuccess);
+		return Read;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTraversalRepStatePackingTest, "WallClimbJump.Traversal.RepStatePacking",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTraversalRepStatePackingTest::RunTest(const FString& Parameters)
+{
+	int64 NumBits = 0;
+	FTraversalRepState Idle;
+	Idle.SurfaceNormal = FVector::UpVector;
+	Idle.GrapplePoint = FVector(1.f, 2.f, 3.f);
+	const FTraversalRepState ReadIdle = TraversalRepStateTest::RoundTrip(Idle, NumBits);
+	TestEqual(TEXT("An idle state is six bits"), NumBits, static_cast<int64>(6));
+	TestTrue(TEXT("Fields an idle state doesn't use are reset on load"), ReadIdle == FTraversalRepState());
+
+	for(int8 Direction = -1; Direction <= 1; ++Direction)
+	{
+		FTraversalRepState Climbing;
+		Climbing.State = ETraversalState::Climbing;
+		Climbing.bIsRotating = Direction != 0;
+		Climbing.ShimmyDirection = Direction;
+		Climbing.SurfaceNormal = FVector(0.f, -1.f, 0.f);
+		Climbing.GrapplePoint = FVector(100.f, 0.f, 0.f);
+		const FTraversalRepState Read = TraversalRepStateTest::RoundTrip(Climbing, NumBits);
+		TestEqual(TEXT("State"), Read.State, ETraversalState::Climbing);
+		TestEqual(TEXT("Rotation flag"), Read.bIsRotating, Climbing.bIsRotating);
+		TestEqual(TEXT("Shimmy direction"), Read.ShimmyDirection, Direction);
+		TestEqual(TEXT("Surface normal"), FVector(Read.SurfaceNormal), FVector(Climbing.SurfaceNormal), 0.01f);
+		TestEqual(TEXT("Climbing doesn't send a grapple point"), FVector(Read.GrapplePoint), FVector::ZeroVector);
+		TestEqual(TEXT("Climbing doesn't send a grapple duration"), Read.GrappleDuration, 0.f);
+		TestNull(TEXT("Climbing doesn't send a ledge"), Read.Ledge);
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Ledge.h"
+#include "Components/BoxComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+/** Game world that lives for one test, actors spawned in it never begin play */
+struct FTraversalTestWorld
+{
+	FTraversalTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+	}
+
+	~FTraversalTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	/** Ledge whose collision is a box of the given half size, with its bounds and grab segment built */
+	ALedge* SpawnLedge(const FVector& Location, const FVector& Extent = FVector(100.f, 20.f, 20.f)) const
+	{
+		ALedge* Ledge = World->SpawnActor<ALedge>();
+		UBoxComponent* Box = NewObject<UBoxComponent>(Ledge);
+		Box->SetBoxExtent(Extent, false);
+		Box->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		Ledge->SetRootComponent(Box);
+		Box->RegisterComponent();
+		Box->SetWorldLocation(Location);
+		Ledge->BuildGrabSegment();
+		return Ledge;
+	}
+
+	UWorld* World;
+};
+
+#endif
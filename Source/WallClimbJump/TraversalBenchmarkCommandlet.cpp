@@ -0,0 +1,653 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TraversalBenchmarkCommandlet.h"
+
+#include "ClimbableWall.h"
+#include "ClimbMovementComponent.h"
+#include "Ledge.h"
+#include "TraversalInputRecording.h"
+#include "WallClimbJump.h"
+#include "WallClimbJumpCharacter.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace TraversalBenchmark
+{
+	constexpr float FrameTime = 1.f / 60.f;
+	constexpr float CellSpacing = 400.f;
+	/** Long enough for the grapple, which launches three seconds after it's started, to land before the script loops */
+	constexpr int32 ScriptLength = 780;
+	/** Viewport the character picks grapple targets in, there is no player viewport in a commandlet */
+	const FIntPoint ViewSize(1920, 1080);
+
+	/** Mean and percentiles of one per-frame series */
+	TSharedRef<FJsonObject> Summarize(TArray<double>& Samples)
+	{
+		TSharedRef<FJsonObject> Summary = MakeShared<FJsonObject>();
+		if(Samples.Num() == 0) return Summary;
+		Samples.Sort();
+		double Total = 0;
+		for(const double Sample : Samples)
+		{
+			Total += Sample;
+		}
+		const auto Percentile = [&Samples](const double P)
+		{
+			return Samples[FMath::Clamp(FMath::CeilToInt(P * Samples.Num()) - 1, 0, Samples.Num() - 1)];
+		};
+		Summary->SetNumberField(TEXT("mean"), Total / Samples.Num());
+		Summary->SetNumberField(TEXT("p50"), Percentile(0.5));
+		Summary->SetNumberField(TEXT("p95"), Percentile(0.95));
+		Summary->SetNumberField(TEXT("p99"), Percentile(0.99));
+		Summary->SetNumberField(TEXT("max"), Samples.Last());
+		return Summary;
+	}
+
+	/** Per-frame series read from GTraversalFrameCounters after each world tick */
+	struct FFrameSamples
+	{
+		TArray<double> WorldTickMs;
+		TArray<double> CharacterTickMs;
+		TArray<double> LocateTargetMs;
+		TArray<double> TracesIssued;
+		TArray<double> LedgesEvaluated;
+		TArray<double> Allocations;
+
+		void Add(const double WorldTick)
+		{
+			WorldTickMs.Add(WorldTick);
+			CharacterTickMs.Add(FPlatformTime::ToMilliseconds64(GTraversalFrameCounters.TickCycles));
+			LocateTargetMs.Add(FPlatformTime::ToMilliseconds64(GTraversalFrameCounters.LocateTargetCycles));
+			TracesIssued.Add(GTraversalFrameCounters.TracesIssued);
+			LedgesEvaluated.Add(GTraversalFrameCounters.LedgesEvaluated);
+			Allocations.Add(GTraversalFrameCounters.Allocations);
+		}
+
+		void Write(FJsonObject& Run)
+		{
+			Run.SetObjectField(TEXT("world_tick_ms"), Summarize(WorldTickMs));
+			Run.SetObjectField(TEXT("character_tick_ms"), Summarize(CharacterTickMs));
+			Run.SetObjectField(TEXT("locate_target_ms"), Summarize(LocateTargetMs));
+			Run.SetObjectField(TEXT("traces_per_frame"), Summarize(TracesIssued));
+			Run.SetObjectField(TEXT("ledges_evaluated_per_frame"), Summarize(LedgesEvaluated));
+			Run.SetObjectField(TEXT("allocations_per_frame"), Summarize(Allocations));
+		}
+	};
+
+	bool WriteResults(const TSharedRef<FJsonObject>& Root, const FString& OutputPath)
+	{
+		FString Json;
+		const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+		FJsonSerializer::Serialize(Root, Writer);
+		if(!FFileHelper::SaveStringToFile(Json, *OutputPath))
+		{
+			UE_LOG(LogTraversal, Error, TEXT("Failed to write benchmark results to %s"), *OutputPath);
+			return false;
+		}
+		UE_LOG(LogTraversal, Display, TEXT("Wrote benchmark results to %s"), *OutputPath);
+		return true;
+	}
+
+	/** Forwards to the real allocator, counting game thread allocations made inside TRAVERSAL_SCOPE_ALLOCATIONS */
+	class FAllocationCounter final : public FMalloc
+	{
+	public:
+		explicit FAllocationCounter(FMalloc* InInner) : Inner(InInner) {}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryMalloc(Count, Alignment);
+		}
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if(Count > 0)
+			{
+				CountAllocation();
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if(Count > 0)
+			{
+				CountAllocation();
+			}
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+		FMalloc* const Inner;
+
+	private:
+		static void CountAllocation()
+		{
+			if(GTraversalAllocationScopeDepth > 0 && IsInGameThread())
+			{
+				++GTraversalFrameCounters.Allocations;
+			}
+		}
+	};
+
+	/** Routes GMalloc through an FAllocationCounter while it lives */
+	struct FScopedAllocationCounter
+	{
+		FScopedAllocationCounter() : Counter(new FAllocationCounter(GMalloc)) { GMalloc = Counter; }
+		// Anything allocated through the counter is owned by the inner allocator, so the counter itself can be leaked safely
+		~FScopedAllocationCounter() { GMalloc = Counter->Inner; }
+
+		FAllocationCounter* const Counter;
+	};
+
+	/** The native classes have no mesh or collision of their own, so a blueprint that fails to load fails the run */
+	template<typename T>
+	UClass* LoadBlueprintClass(const TCHAR* Path)
+	{
+		UClass* Class = StaticLoadClass(T::StaticClass(), nullptr, Path, nullptr, LOAD_Quiet | LOAD_NoWarn);
+		if(!Class)
+		{
+			UE_LOG(LogTraversal, Error, TEXT("Could not load %s"), Path);
+		}
+		return Class;
+	}
+}
+
+UTraversalBenchmarkCommandlet::UTraversalBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UTraversalBenchmarkCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamMap;
+	ParseCommandLine(*Params, Tokens, Switches, ParamMap);
+
+	if(const FString* ReplayParam = ParamMap.Find(TEXT("Replay")))
+	{
+		TArray<FString> Recordings;
+		ReplayParam->ParseIntoArray(Recordings, TEXT(","), true);
+		return RunReplays(Recordings, ParamMap);
+	}
+
+	TArray<int32> Counts = {100, 1000, 10000, 100000};
+	if(const FString* CountsParam = ParamMap.Find(TEXT("Counts")))
+	{
+		TArray<FString> Parts;
+		CountsParam->ParseIntoArray(Parts, TEXT(","), true);
+		Counts.Reset();
+		for(const FString& Part : Parts)
+		{
+			Counts.Add(FMath::Max(FCString::Atoi(*Part), 1));
+		}
+	}
+	const FString* FramesParam = ParamMap.Find(TEXT("Frames"));
+	int32 NumFrames = FramesParam ? FMath::Max(FCString::Atoi(**FramesParam), 1) : TraversalBenchmark::ScriptLength;
+	const bool bCheckAllocations = Switches.Contains(TEXT("CheckAllocations"));
+	if(bCheckAllocations)
+	{
+		// The first pass through the script warms up scratch buffers, only later passes are steady state
+		NumFrames = FMath::Max(NumFrames, TraversalBenchmark::ScriptLength * 2);
+	}
+	const bool bCompareParallelScoring = Switches.Contains(TEXT("CompareParallelScoring"));
+	const FString* OutputParam = ParamMap.Find(TEXT("Output"));
+	const FString OutputPath = OutputParam ? *OutputParam : FPaths::ProfilingDir() / TEXT("TraversalBenchmark.json");
+
+	TUniquePtr<TraversalBenchmark::FScopedAllocationCounter> AllocationCounter;
+	if(bCheckAllocations)
+	{
+		AllocationCounter = MakeUnique<TraversalBenchmark::FScopedAllocationCounter>();
+	}
+
+	int32 Result = 0;
+	TArray<TSharedPtr<FJsonValue>> Runs;
+	for(const int32 Count : Counts)
+	{
+		UE_LOG(LogTraversal, Display, TEXT("Running traversal benchmark with %d ledges and %d walls"), Count, Count);
+		const TSharedPtr<FJsonObject> Run = RunScenario(Count, NumFrames, bCompareParallelScoring);
+		if(!Run)
+		{
+			Result = 1;
+			continue;
+		}
+		if(NumFrames >= TraversalBenchmark::ScriptLength && (!Run->GetBoolField(TEXT("reached_hang")) || !Run->GetBoolField(TEXT("reached_grapple"))))
+		{
+			UE_LOG(LogTraversal, Error, TEXT("Script did not reach both hanging and grappling with %d ledges, the run doesn't cover the traversal it measures"), Count);
+			Result = 1;
+		}
+		const int32 ScoringMismatches = static_cast<int32>(Run->GetNumberField(TEXT("scoring_mismatches")));
+		if(ScoringMismatches > 0)
+		{
+			UE_LOG(LogTraversal, Error, TEXT("Serial and parallel target scoring disagreed on %d frames with %d ledges"), ScoringMismatches, Count);
+			Result = 1;
+		}
+		const int32 SteadyStateAllocations = static_cast<int32>(Run->GetNumberField(TEXT("steady_state_allocations")));
+		if(bCheckAllocations && SteadyStateAllocations > 0)
+		{
+			UE_LOG(LogTraversal, Error, TEXT("Traversal hot path made %d allocations in steady state frames with %d ledges"), SteadyStateAllocations, Count);
+			Result = 1;
+		}
+		Runs.Add(MakeShared<FJsonValueObject>(Run));
+	}
+
+	AllocationCounter.Reset();
+
+	const TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("build"), FApp::GetBuildVersion());
+	Root->SetNumberField(TEXT("frames"), NumFrames);
+	Root->SetArrayField(TEXT("runs"), Runs);
+	return TraversalBenchmark::WriteResults(Root, OutputPath) ? Result : 1;
+}
+
+TSharedPtr<FJsonObject> UTraversalBenchmarkCommandlet::RunAllocationCheck(const int32 ActorCount) const
+{
+	const TraversalBenchmark::FScopedAllocationCounter AllocationCounter;
+	return RunScenario(ActorCount, TraversalBenchmark::ScriptLength * 2, false);
+}
+
+TSharedPtr<FJsonObject> UTraversalBenchmarkCommandlet::RunScenario(const int32 ActorCount, const int32 NumFrames, const bool bCompareParallelScoring) const
+{
+	UClass* CharacterClass = TraversalBenchmark::LoadBlueprintClass<AWallClimbJumpCharacter>(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter.ThirdPersonCharacter_C"));
+	UClass* WallClass = TraversalBenchmark::LoadBlueprintClass<AClimbableWall>(TEXT("/Game/BP_ClimableWall.BP_ClimableWall_C"));
+	UClass* LedgeClass = TraversalBenchmark::LoadBlueprintClass<ALedge>(TEXT("/Game/BP_Ledge.BP_Ledge_C"));
+	if(!CharacterClass || !WallClass || !LedgeClass) return nullptr;
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, FName(*FString::Printf(TEXT("TraversalBenchmark_%d"), ActorCount)));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	// A game mode is needed for BeginPlay to be dispatched, actors spawned afterwards begin play straight away
+	const FURL URL;
+	World->SetGameMode(URL);
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+
+	PopulateWorld(World, ActorCount, WallClass, LedgeClass);
+	AWallClimbJumpCharacter* Character = World->SpawnActor<AWallClimbJumpCharacter>(CharacterClass, FVector(0, 0, 100), FRotator::ZeroRotator);
+	if(Character)
+	{
+		Character->SpawnDefaultController();
+		Character->HeadlessViewSize = TraversalBenchmark::ViewSize;
+	}
+
+	TraversalBenchmark::FFrameSamples Samples;
+	int32 SteadyStateAllocations = 0;
+	int32 ScoringMismatches = 0;
+	bool bReachedHang = false;
+	bool bReachedGrapple = false;
+	for(int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		GTraversalFrameCounters.Reset();
+		if(Character)
+		{
+			DriveScript(Character, Frame);
+		}
+		const double StartTime = FPlatformTime::Seconds();
+		World->Tick(LEVELTICK_All, TraversalBenchmark::FrameTime);
+		Samples.Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+		if(Frame >= TraversalBenchmark::ScriptLength)
+		{
+			SteadyStateAllocations += GTraversalFrameCounters.Allocations;
+		}
+		if(Character)
+		{
+			bReachedHang |= Character->GetClimbMovement()->IsInCustomMode(CMOVE_Hang);
+			bReachedGrapple |= Character->GetClimbMovement()->IsInCustomMode(CMOVE_Grapple);
+			// After the frame's samples are taken, so the extra sweeps don't show up in them
+			if(bCompareParallelScoring && !CompareTargetScoring(Character))
+			{
+				++ScoringMismatches;
+			}
+		}
+		++GFrameCounter;
+	}
+
+	const TSharedRef<FJsonObject> Run = MakeShared<FJsonObject>();
+	Run->SetNumberField(TEXT("ledges"), ActorCount);
+	Run->SetNumberField(TEXT("walls"), ActorCount);
+	Samples.Write(*Run);
+	Run->SetNumberField(TEXT("steady_state_allocations"), SteadyStateAllocations);
+	Run->SetNumberField(TEXT("scoring_mismatches"), ScoringMismatches);
+	Run->SetBoolField(TEXT("reached_hang"), bReachedHang);
+	Run->SetBoolField(TEXT("reached_grapple"), bReachedGrapple);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	return Run;
+}
+
+int32 UTraversalBenchmarkCommandlet::RunReplays(const TArray<FString>& Recordings, const TMap<FString, FString>& ParamMap) const
+{
+	// End locations from an earlier run, by recording file name
+	TMap<FString, FVector> BaselineEnds;
+	if(const FString* BaselineParam = ParamMap.Find(TEXT("Baseline")))
+	{
+		FString BaselineJson;
+		TSharedPtr<FJsonObject> Baseline;
+		const TArray<TSharedPtr<FJsonValue>>* BaselineReplays = nullptr;
+		if(!FFileHelper::LoadFileToString(BaselineJson, **BaselineParam) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineJson), Baseline)
+			|| !Baseline.IsValid() || !Baseline->TryGetArrayField(TEXT("replays"), BaselineReplays))
+		{
+			UE_LOG(LogTraversal, Error, TEXT("Could not read replay results from %s"), **BaselineParam);
+			return 1;
+		}
+		for(const TSharedPtr<FJsonValue>& Value : *BaselineReplays)
+		{
+			const TSharedPtr<FJsonObject> Replay = Value->AsObject();
+			const TSharedPtr<FJsonObject>* End = nullptr;
+			if(!Replay || !Replay->TryGetObjectField(TEXT("end_location"), End)) continue;
+			BaselineEnds.Add(Replay->GetStringField(TEXT("recording")), FVector((*End)->GetNumberField(TEXT("x")), (*End)->GetNumberField(TEXT("y")), (*End)->GetNumberField(TEXT("z"))));
+		}
+	}
+	const FString* ToleranceParam = ParamMap.Find(TEXT("Tolerance"));
+	const float Tolerance = ToleranceParam ? FCString::Atof(**ToleranceParam) : 1.f;
+	const FString* OutputParam = ParamMap.Find(TEXT("Output"));
+	const FString OutputPath = OutputParam ? *OutputParam : FPaths::ProfilingDir() / TEXT("TraversalReplay.json");
+
+	int32 Result = 0;
+	TArray<TSharedPtr<FJsonValue>> Replays;
+	for(const FString& Recording : Recordings)
+	{
+		// Bare names refer to recordings saved by traversal.StopRecordingInput
+		const FString Filename = FPaths::FileExists(Recording) ? Recording : FTraversalInputRecording::GetRecordingPath(Recording);
+		UE_LOG(LogTraversal, Display, TEXT("Replaying traversal input from %s"), *Filename);
+		const TSharedPtr<FJsonObject> Replay = ReplayRecording(Filename);
+		if(!Replay)
+		{
+			Result = 1;
+			continue;
+		}
+		const TSharedPtr<FJsonObject>& End = Replay->GetObjectField(TEXT("end_location"));
+		const FVector EndLocation(End->GetNumberField(TEXT("x")), End->GetNumberField(TEXT("y")), End->GetNumberField(TEXT("z")));
+		const float RecordedDrift = Replay->GetNumberField(TEXT("recorded_end_drift"));
+		if(RecordedDrift > Tolerance)
+		{
+			UE_LOG(LogTraversal, Error, TEXT("%s ended at %s, %.2f units from where the recording ended"), *Filename, *EndLocation.ToString(), RecordedDrift);
+			Result = 1;
+		}
+		if(const FVector* BaselineEnd = BaselineEnds.Find(Replay->GetStringField(TEXT("recording"))))
+		{
+			const float Drift = FVector::Dist(EndLocation, *BaselineEnd);
+			Replay->SetNumberField(TEXT("end_drift"), Drift);
+			if(Drift > Tolerance)
+			{
+				UE_LOG(LogTraversal, Error, TEXT("%s ended at %s, %.2f units from the baseline end %s"), *Filename, *EndLocation.ToString(), Drift, *BaselineEnd->ToString());
+				Result = 1;
+			}
+		}
+		else if(BaselineEnds.Num() > 0)
+		{
+			UE_LOG(LogTraversal, Warning, TEXT("%s is not in the baseline, its end location was not checked"), *Filename);
+		}
+		Replays.Add(MakeShared<FJsonValueObject>(Replay));
+	}
+
+	const TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("build"), FApp::GetBuildVersion());
+	Root->SetNumberField(TEXT("frame_time"), TraversalBenchmark::FrameTime);
+	Root->SetArrayField(TEXT("replays"), Replays);
+	return TraversalBenchmark::WriteResults(Root, OutputPath) ? Result : 1;
+}
+
+TSharedPtr<FJsonObject> UTraversalBenchmarkCommandlet::ReplayRecording(const FString& Filename) const
+{
+	FTraversalInputRecording Recording;
+	if(!Recording.LoadFromFile(Filename) || Recording.Frames.Num() == 0)
+	{
+		UE_LOG(LogTraversal, Error, TEXT("Could not load traversal input recording %s"), *Filename);
+		return nullptr;
+	}
+	UClass* CharacterClass = TraversalBenchmark::LoadBlueprintClass<AWallClimbJumpCharacter>(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter.ThirdPersonCharacter_C"));
+	if(!CharacterClass) return nullptr;
+	UPackage* MapPackage = LoadPackage(nullptr, *Recording.MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if(!World)
+	{
+		UE_LOG(LogTraversal, Error, TEXT("Could not load map %s recorded in %s"), *Recording.MapName, *Filename);
+		return nullptr;
+	}
+
+	World->WorldType = EWorldType::Game;
+	World->AddToRoot();
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	if(!World->bIsWorldInitialized)
+	{
+		UWorld::InitializationValues InitValues;
+		InitValues.RequiresHitProxies(false)
+			.AllowAudioPlayback(false);
+		World->InitWorld(InitValues);
+	}
+	World->UpdateWorldComponents(true, false);
+	const FURL URL;
+	World->SetGameMode(URL);
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AWallClimbJumpCharacter* Character = World->SpawnActor<AWallClimbJumpCharacter>(CharacterClass, Recording.StartLocation, Recording.StartRotation, SpawnParams);
+	if(Character)
+	{
+		Character->SpawnDefaultController();
+		Character->HeadlessViewSize = TraversalBenchmark::ViewSize;
+	}
+
+	// Each fixed step takes every recorded frame that started before it ends, keeping the latest axes and all actions
+	const int32 NumSteps = FMath::FloorToInt(Recording.Frames.Last().Time / TraversalBenchmark::FrameTime) + 1;
+	TraversalBenchmark::FFrameSamples Samples;
+	FTraversalInputFrame Input;
+	int32 NextFrame = 0;
+	for(int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		GTraversalFrameCounters.Reset();
+		const double StepEnd = (Step + 1) * static_cast<double>(TraversalBenchmark::FrameTime);
+		ETraversalInputAction Actions = ETraversalInputAction::None;
+		for(; NextFrame < Recording.Frames.Num() && Recording.Frames[NextFrame].Time < StepEnd; ++NextFrame)
+		{
+			Input = Recording.Frames[NextFrame];
+			Actions |= Input.Actions;
+		}
+		Input.Actions = Actions;
+		if(Character)
+		{
+			ApplyInput(Character, Input);
+		}
+		const double StartTime = FPlatformTime::Seconds();
+		World->Tick(LEVELTICK_All, TraversalBenchmark::FrameTime);
+		Samples.Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+		++GFrameCounter;
+	}
+
+	const TSharedRef<FJsonObject> Replay = MakeShared<FJsonObject>();
+	Replay->SetStringField(TEXT("recording"), FPaths::GetCleanFilename(Filename));
+	Replay->SetStringField(TEXT("map"), Recording.MapName);
+	Replay->SetNumberField(TEXT("recorded_frames"), Recording.Frames.Num());
+	Replay->SetNumberField(TEXT("frames"), NumSteps);
+	Samples.Write(*Replay);
+	const FVector EndLocation = Character ? Character->GetActorLocation() : FVector::ZeroVector;
+	const TSharedRef<FJsonObject> End = MakeShared<FJsonObject>();
+	End->SetNumberField(TEXT("x"), EndLocation.X);
+	End->SetNumberField(TEXT("y"), EndLocation.Y);
+	End->SetNumberField(TEXT("z"), EndLocation.Z);
+	Replay->SetObjectField(TEXT("end_location"), End);
+	Replay->SetNumberField(TEXT("recorded_end_drift"), FVector::Dist(EndLocation, Recording.EndLocation));
+
+	GEngine->DestroyWorldContext(World);
+	World->RemoveFromRoot();
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	return Replay;
+}
+
+void UTraversalBenchmarkCommandlet::PopulateWorld(UWorld* World, const int32 ActorCount, UClass* WallClass, UClass* LedgeClass) const
+{
+	const int32 Side = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(ActorCount)));
+	const float HalfWidth = Side * TraversalBenchmark::CellSpacing * 0.5f;
+
+	// Floor covering the whole layout, cube meshes are 100 units across
+	AStaticMeshActor* Floor = World->SpawnActor<AStaticMeshActor>(FVector(0, 0, -50), FRotator::ZeroRotator);
+	UStaticMesh* CubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if(Floor && CubeMesh)
+	{
+		Floor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+		Floor->GetStaticMeshComponent()->SetStaticMesh(CubeMesh);
+		Floor->SetActorScale3D(FVector((HalfWidth + 1000.f) / 50.f, (HalfWidth + 1000.f) / 50.f, 1.f));
+	}
+
+	// Walls in a grid starting just in front of the character, each with a ledge beside it
+	for(int32 Index = 0; Index < ActorCount; ++Index)
+	{
+		const float X = 150.f + (Index / Side) * TraversalBenchmark::CellSpacing;
+		const float Y = (Index % Side) * TraversalBenchmark::CellSpacing - HalfWidth;
+		World->SpawnActor<AClimbableWall>(WallClass, FVector(X, Y, 200.f), FRotator::ZeroRotator);
+		World->SpawnActor<ALedge>(LedgeClass, FVector(X, Y + TraversalBenchmark::CellSpacing * 0.5f, 260.f), FRotator::ZeroRotator);
+	}
+}
+
+void UTraversalBenchmarkCommandlet::DriveScript(AWallClimbJumpCharacter* Character, const int32 Frame) const
+{
+	// Walk, climb, drop, hang and shimmy both ways, let go and grapple, then idle
+	const int32 Step = Frame % TraversalBenchmark::ScriptLength;
+	if(Step < 120)
+	{
+		Character->MoveForward(1.f);
+	}
+	else if(Step == 120 || Step == 240)
+	{
+		Character->WallAttach();
+	}
+	else if(Step < 240)
+	{
+		Character->MoveForward(1.f);
+	}
+	else if(Step == 241 || Step == 480)
+	{
+		Character->Jump();
+	}
+	else if(Step < 360)
+	{
+		Character->MoveRight(1.f);
+	}
+	else if(Step < 480)
+	{
+		Character->MoveRight(-1.f);
+	}
+	else if(Step == 481)
+	{
+		Character->StartGrapple();
+	}
+	else
+	{
+		Character->MoveRight(0.f);
+	}
+}
+
+bool UTraversalBenchmarkCommandlet::CompareTargetScoring(AWallClimbJumpCharacter* Character) const
+{
+	IConsoleVariable* ThresholdVar = IConsoleManager::Get().FindConsoleVariable(TEXT("traversal.ParallelTargetThreshold"));
+	if(!ThresholdVar) return true;
+
+	// LocateTarget moves the sweep and the target on, everything is put back afterwards so the script plays out as usual
+	const int32 Threshold = ThresholdVar->GetInt();
+	const int32 SliceSize = Character->TargetSliceSize;
+	const int32 ScanCursor = Character->TargetScanCursor;
+	const TArray<ALedge*> Candidates = Character->LedgeCandidates;
+	const bool bSweepAllLedges = Character->bSweepAllLedges;
+	ALedge* const BestLedge = Character->SweepBestLedge;
+	const FVector BestPoint = Character->SweepBestPoint;
+	ALedge* const TargetLedge = Character->TargetLedge;
+	const FVector GrapplePoint = Character->GrapplePoint;
+
+	// Both sweeps start from the same target, it is left out of the sweep's best
+	const auto ScoreSweep = [Character, ThresholdVar, TargetLedge, &GrapplePoint](const int32 SweepThreshold)
+	{
+		ThresholdVar->Set(SweepThreshold, ECVF_SetByCode);
+		Character->TargetLedge = TargetLedge;
+		Character->GrapplePoint = GrapplePoint;
+		Character->TargetScanCursor = 0;
+		Character->LocateTarget();
+	};
+	Character->TargetSliceSize = 0;
+	ScoreSweep(0);
+	ALedge* const SerialLedge = Character->SweepBestLedge;
+	const FVector SerialPoint = Character->SweepBestPoint;
+	ScoreSweep(1);
+	const bool bAgree = SerialLedge == Character->SweepBestLedge && SerialPoint == Character->SweepBestPoint;
+	if(!bAgree)
+	{
+		UE_LOG(LogTraversal, Warning, TEXT("Serial scoring picked %s at %s, parallel scoring picked %s at %s"),
+			*GetNameSafe(SerialLedge), *SerialPoint.ToString(), *GetNameSafe(Character->SweepBestLedge), *Character->SweepBestPoint.ToString());
+	}
+
+	ThresholdVar->Set(Threshold, ECVF_SetByCode);
+	Character->TargetSliceSize = SliceSize;
+	Character->TargetScanCursor = ScanCursor;
+	Character->LedgeCandidates = Candidates;
+	Character->bSweepAllLedges = bSweepAllLedges;
+	Character->SweepBestLedge = BestLedge;
+	Character->SweepBestPoint = BestPoint;
+	Character->TargetLedge = TargetLedge;
+	Character->GrapplePoint = GrapplePoint;
+	Character->UpdateTargetMarker();
+	return bAgree;
+}
+
+void UTraversalBenchmarkCommandlet::ApplyInput(AWallClimbJumpCharacter* Character, const FTraversalInputFrame& Input) const
+{
+	if(AController* Controller = Character->GetController())
+	{
+		Controller->SetControlRotation(Input.GetControlRotation());
+	}
+	// Same order the input stack uses, actions before axes
+	if(EnumHasAnyFlags(Input.Actions, ETraversalInputAction::Jump))
+	{
+		Character->Jump();
+	}
+	if(EnumHasAnyFlags(Input.Actions, ETraversalInputAction::StopJumping))
+	{
+		Character->StopJumping();
+	}
+	if(EnumHasAnyFlags(Input.Actions, ETraversalInputAction::Climb))
+	{
+		Character->WallAttach();
+	}
+	if(EnumHasAnyFlags(Input.Actions, ETraversalInputAction::Grapple))
+	{
+		Character->StartGrapple();
+	}
+	Character->MoveForward(Input.GetForward());
+	Character->MoveRight(Input.GetRight());
+}
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TraversalBenchmarkCommandlet.generated.h"
+
+/**
+ * Measures traversal cost in generated worlds of increasing ledge and wall counts while
+ * driving a character through a scripted climb, hang, shimmy and grapple loop.
+ *
+ * A run covering the whole script fails if it never gets the character hanging and grappling. With -CheckAllocations the
+ * traversal hot path is also counted for heap allocations, failing the run if any are made once the script loops.
+ * With -CompareParallelScoring every frame's grapple target sweep is scored again on the game thread and on workers,
+ * failing the run if the two pick a different ledge or grapple point.
+ *
+ * UE4Editor-Cmd WallClimbJump.uproject -run=TraversalBenchmark -nullrhi [-Counts=100,1000] [-Frames=780] [-Output=Path.json] [-CheckAllocations] [-CompareParallelScoring]
+ *
+ * With -Replay the character is instead driven through recordings made with traversal.RecordInput, in the
+ * maps they were made in and at a fixed timestep. A replay fails if it ends further than -Tolerance units (1 by default)
+ * from where the recording ended, or, with the results of an earlier run passed as -Baseline, from where it ended before.
+ *
+ * UE4Editor-Cmd WallClimbJump.uproject -run=TraversalBenchmark -nullrhi -Replay=Name[,Path.tinput] [-Baseline=Path.json] [-Tolerance=1] [-Output=Path.json]
+ */
+UCLASS()
+class WALLCLIMBJUMP_API UTraversalBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTraversalBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+	/**
+	 * Runs the script through twice with the hot path's allocations counted, as -CheckAllocations does. Null if the
+	 * scenario couldn't be built, otherwise the run's steady_state_allocations, reached_hang and reached_grapple say how it went.
+	 */
+	TSharedPtr<class FJsonObject> RunAllocationCheck(int32 ActorCount) const;
+
+private:
+	/** Null if the blueprints the scenario is built from couldn't be loaded */
+	TSharedPtr<class FJsonObject> RunScenario(int32 ActorCount, int32 NumFrames, bool bCompareParallelScoring) const;
+	int32 RunReplays(const TArray<FString>& Recordings, const TMap<FString, FString>& ParamMap) const;
+	/** Null if the recording, its map or the character blueprint couldn't be loaded */
+	TSharedPtr<class FJsonObject> ReplayRecording(const FString& Filename) const;
+	void DriveScript(class AWallClimbJumpCharacter* Character, int32 Frame) const;
+	/** Scores a whole sweep from where the character stands serially and in parallel, false if they disagree */
+	bool CompareTargetScoring(class AWallClimbJumpCharacter* Character) const;
+	void ApplyInput(class AWallClimbJumpCharacter* Character, const struct FTraversalInputFrame& Input) const;
+	void PopulateWorld(UWorld* World, int32 ActorCount, UClass* WallClass, UClass* LedgeClass) const;
+};
@@ -0,0 +1,11 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TraversalGraph.h"
+
+#include "Misc/PackageName.h"
+
+FString UTraversalGraph::GetPackageNameForMap(const FString& MapName)
+{
+	return FString::Printf(TEXT("/Game/TraversalGraphs/TG_%s"), *FPackageName::GetShortName(MapName));
+}
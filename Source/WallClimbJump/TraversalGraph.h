@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "TraversalGraph.generated.h"
+
+UENUM()
+enum class ETraversalNodeType : uint8
+{
+	Ledge,
+	Wall
+};
+
+UENUM()
+enum class ETraversalEdgeType : uint8
+{
+	/** Hanging move along joined ledge edges */
+	Shimmy,
+	/** Side jump off the end of a ledge onto another one */
+	Hop,
+	/** Climb a wall up to a ledge along its top */
+	ClimbUp,
+	Grapple
+};
+
+USTRUCT()
+struct FTraversalGraphNode
+{
+	GENERATED_BODY()
+
+	/** Middle of a ledge's grab edge, or the centre of a wall */
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	FVector Location = FVector::ZeroVector;
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	ETraversalNodeType Type = ETraversalNodeType::Ledge;
+	/** Outgoing edges are Edges[FirstEdge, FirstEdge + NumEdges) */
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	int32 FirstEdge = 0;
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	int32 NumEdges = 0;
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	TSoftObjectPtr<AActor> Actor;
+};
+
+USTRUCT()
+struct FTraversalGraphEdge
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	int32 To = INDEX_NONE;
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	ETraversalEdgeType Type = ETraversalEdgeType::Shimmy;
+	/** Seconds the move takes with default movement settings */
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	float Cost = 0.f;
+};
+
+/**
+ * Walls and ledges of one map and the traversal moves between them, baked offline by the
+ * TraversalGraphBake commandlet so AI can plan routes the nav mesh doesn't know about.
+ */
+UCLASS()
+class WALLCLIMBJUMP_API UTraversalGraph : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Package the bake writes a map's graph to and UTraversalPathSubsystem loads it from */
+	static FString GetPackageNameForMap(const FString& MapName);
+
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	TArray<FTraversalGraphNode> Nodes;
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	TArray<FTraversalGraphEdge> Edges;
+	/** Fastest straight line speed over any edge, keeps the A* heuristic from overestimating */
+	UPROPERTY(VisibleAnywhere, Category=Traversal)
+	float HeuristicSpeed = 1.f;
+};
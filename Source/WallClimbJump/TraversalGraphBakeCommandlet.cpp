@@ -0,0 +1,274 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TraversalGraphBakeCommandlet.h"
+
+#include "ClimbableWall.h"
+#include "ClimbMovementComponent.h"
+#include "EngineUtils.h"
+#include "Ledge.h"
+#include "LedgeSpatialGrid.h"
+#include "LedgeSubsystem.h"
+#include "TraversalGraph.h"
+#include "WallClimbJump.h"
+#include "WallClimbJumpCharacter.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+namespace TraversalGraphBake
+{
+	/** Side speed of the hop off a ledge end, the impulse AWallClimbJumpCharacter::Jump applies */
+	constexpr float HopSpeed = 970.f;
+	/** Widest gap a hop clears and how far it can fall on the way */
+	constexpr float HopReach = 350.f;
+	constexpr float HopDrop = 300.f;
+	/** Time spent letting go and catching the next ledge, on top of the flight */
+	constexpr float HopRecoverTime = 0.5f;
+	/** How close a ledge has to be to a wall's top to climb up onto it */
+	constexpr float ClimbUpTolerance = 100.f;
+	/** StartGrapple waits this long before the launch */
+	constexpr float GrapplePrepareTime = 3.f;
+	/** Grapple edges are baked up to this far when the character's own range is unbounded */
+	constexpr float DefaultGrappleRange = 5000.f;
+
+	struct FBakeNode
+	{
+		FVector Location = FVector::ZeroVector;
+		ETraversalNodeType Type = ETraversalNodeType::Ledge;
+		AActor* Actor = nullptr;
+		/** Null for walls */
+		ALedge* Ledge = nullptr;
+		FBox WallBounds = FBox(ForceInit);
+		TArray<FTraversalGraphEdge> Edges;
+
+		void AddEdge(const int32 To, const ETraversalEdgeType Type, const float Cost)
+		{
+			FTraversalGraphEdge& Edge = Edges.AddDefaulted_GetRef();
+			Edge.To = To;
+			Edge.Type = Type;
+			Edge.Cost = Cost;
+		}
+	};
+}
+
+UTraversalGraphBakeCommandlet::UTraversalGraphBakeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UTraversalGraphBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamMap;
+	ParseCommandLine(*Params, Tokens, Switches, ParamMap);
+
+	const FString* MapParam = ParamMap.Find(TEXT("Map"));
+	if(!MapParam)
+	{
+		UE_LOG(LogTraversal, Error, TEXT("Pass the maps to bake with -Map=/Game/Path/Map[,/Game/Path/Other]"));
+		return 1;
+	}
+	TArray<FString> Maps;
+	MapParam->ParseIntoArray(Maps, TEXT(","), true);
+
+	// Unbounded, every ledge pair in the map would get a trace and most of them an edge
+	const FString* RangeParam = ParamMap.Find(TEXT("GrappleRange"));
+	float GrappleRange = RangeParam ? FCString::Atof(**RangeParam) : GetDefault<AWallClimbJumpCharacter>()->GrappleRange;
+	if(GrappleRange <= 0.f)
+	{
+		GrappleRange = TraversalGraphBake::DefaultGrappleRange;
+		UE_LOG(LogTraversal, Warning, TEXT("The character's grapple range is unbounded, baking grapple edges up to %.0f units. Pass -GrappleRange to change it"), GrappleRange);
+	}
+
+	int32 Result = 0;
+	for(const FString& Map : Maps)
+	{
+		if(!BakeMap(Map, GrappleRange))
+		{
+			Result = 1;
+		}
+	}
+	return Result;
+#else
+	UE_LOG(LogTraversal, Error, TEXT("Traversal graphs can only be baked from an editor build"));
+	return 1;
+#endif
+}
+
+bool UTraversalGraphBakeCommandlet::BakeMap(const FString& MapPackageName, const float GrappleRange) const
+{
+#if WITH_EDITOR
+	UPackage* MapPackage = LoadPackage(nullptr, *MapPackageName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if(!World)
+	{
+		UE_LOG(LogTraversal, Error, TEXT("Could not load map %s"), *MapPackageName);
+		return false;
+	}
+
+	// Collision is only needed for the grapple line of sight traces
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	if(!World->bIsWorldInitialized)
+	{
+		UWorld::InitializationValues InitValues;
+		InitValues.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(true)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true);
+		World->InitWorld(InitValues);
+	}
+	World->UpdateWorldComponents(true, false);
+
+	const FString GraphPackageName = UTraversalGraph::GetPackageNameForMap(MapPackageName);
+	UPackage* GraphPackage = CreatePackage(*GraphPackageName);
+	UTraversalGraph* Graph = NewObject<UTraversalGraph>(GraphPackage, *FPackageName::GetShortName(GraphPackageName), RF_Public | RF_Standalone);
+	BuildGraph(World, Graph, GrappleRange);
+	GraphPackage->MarkPackageDirty();
+
+	const FString Filename = FPackageName::LongPackageNameToFilename(GraphPackageName, FPackageName::GetAssetPackageExtension());
+	const bool bSaved = UPackage::SavePackage(GraphPackage, Graph, RF_Public | RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError);
+	if(bSaved)
+	{
+		UE_LOG(LogTraversal, Display, TEXT("Baked %d traversal nodes and %d edges for %s into %s"), Graph->Nodes.Num(), Graph->Edges.Num(), *MapPackageName, *Filename);
+	}
+	else
+	{
+		UE_LOG(LogTraversal, Error, TEXT("Failed to save traversal graph %s"), *Filename);
+	}
+
+	World->RemoveFromRoot();
+	World->CleanupWorld();
+	return bSaved;
+#else
+	return false;
+#endif
+}
+
+void UTraversalGraphBakeCommandlet::BuildGraph(UWorld* World, UTraversalGraph* Graph, const float GrappleRange) const
+{
+	using namespace TraversalGraphBake;
+	const UClimbMovementComponent* Movement = GetDefault<UClimbMovementComponent>();
+
+	TArray<FBakeNode> Nodes;
+	for(TActorIterator<ALedge> It(World); It; ++It)
+	{
+		ALedge* Ledge = *It;
+		Ledge->BuildGrabSegment();
+		// Without a straight edge there is nothing to shimmy along or aim at ahead of time
+		if(!Ledge->HasGrabSegment()) continue;
+		FBakeNode& Node = Nodes.AddDefaulted_GetRef();
+		Node.Location = (Ledge->GetGrabSegment().Start + Ledge->GetGrabSegment().End) * 0.5f;
+		Node.Type = ETraversalNodeType::Ledge;
+		Node.Actor = Ledge;
+		Node.Ledge = Ledge;
+	}
+	for(TActorIterator<AClimbableWall> It(World); It; ++It)
+	{
+		const FBox Bounds = It->GetWallBounds();
+		if(!Bounds.IsValid) continue;
+		FBakeNode& Node = Nodes.AddDefaulted_GetRef();
+		Node.Location = Bounds.GetCenter();
+		Node.Type = ETraversalNodeType::Wall;
+		Node.Actor = *It;
+		Node.WallBounds = Bounds;
+	}
+
+	// Every move ends on a ledge, so only ledges go in the grid, keyed and ordered by node index
+	FLedgeSpatialGrid Grid;
+	TMap<const ALedge*, int32> LedgeNodes;
+	for(int32 Index = 0; Index < Nodes.Num(); ++Index)
+	{
+		if(!Nodes[Index].Ledge) continue;
+		Grid.Add(Index, Nodes[Index].Ledge, Index);
+		LedgeNodes.Add(Nodes[Index].Ledge, Index);
+	}
+	const float HopRange = FVector2D(HopReach, HopDrop).Size();
+
+	// Each pair keeps one move and only grapples when nothing else reaches
+	TArray<ALedge*> Candidates;
+	for(int32 From = 0; From < Nodes.Num(); ++From)
+	{
+		FBakeNode& Source = Nodes[From];
+		// Far enough from the node's centre to take in any target one of its moves could reach
+		const float MoveRange = Source.Ledge ? Source.Ledge->GetGrabSegment().GetLength() * 0.5f + HopRange : Source.WallBounds.GetExtent().Size() + ClimbUpTolerance * 2.f;
+		Grid.QuerySphere(Source.Location, FMath::Max(MoveRange, GrappleRange), Candidates);
+		for(const ALedge* Candidate : Candidates)
+		{
+			const int32 To = LedgeNodes.FindChecked(Candidate);
+			const FBakeNode& Target = Nodes[To];
+			if(To == From) continue;
+			const FLedgeGrabSegment& TargetEdge = Target.Ledge->GetGrabSegment();
+
+			if(Source.Ledge)
+			{
+				const FLedgeGrabSegment& SourceEdge = Source.Ledge->GetGrabSegment();
+				if(ULedgeSubsystem::FindJoinedEnd(SourceEdge, 0, TargetEdge) != INDEX_NONE || ULedgeSubsystem::FindJoinedEnd(SourceEdge, 1, TargetEdge) != INDEX_NONE)
+				{
+					Source.AddEdge(To, ETraversalEdgeType::Shimmy, FVector::Dist(Source.Location, Target.Location) / FMath::Max(Movement->MaxHangSpeed, 1.f));
+					continue;
+				}
+				bool bHop = false;
+				for(int32 End = 0; End < 2 && !bHop; ++End)
+				{
+					// Hops go sideways off an end and can only lose height
+					const FVector EndPoint = End ? SourceEdge.End : SourceEdge.Start;
+					const FVector Outward = SourceEdge.GetDirection() * (End ? 1.f : -1.f);
+					const FVector Gap = TargetEdge.GetClosestPoint(EndPoint) - EndPoint;
+					const float Drop = -Gap.Z;
+					if(FVector::DotProduct(Gap, Outward) <= 0 || Gap.Size2D() > HopReach || Drop < 0 || Drop > HopDrop) continue;
+					Source.AddEdge(To, ETraversalEdgeType::Hop, HopRecoverTime + Gap.Size2D() / HopSpeed);
+					bHop = true;
+				}
+				if(bHop) continue;
+			}
+			else
+			{
+				const FBox& Wall = Source.WallBounds;
+				if(FMath::Abs(TargetEdge.HangHeight - Wall.Max.Z) <= ClimbUpTolerance && Wall.ExpandBy(ClimbUpTolerance).IsInsideXY(Target.Location))
+				{
+					Source.AddEdge(To, ETraversalEdgeType::ClimbUp, FMath::Max(Wall.Max.Z - Source.Location.Z, 0.f) / FMath::Max(Movement->MaxClimbSpeed, 1.f));
+					continue;
+				}
+			}
+
+			const FVector GrapplePoint = TargetEdge.GetClosestPoint(Source.Location);
+			const float GrappleDistance = FVector::Dist(Source.Location, GrapplePoint);
+			if(GrappleDistance > GrappleRange) continue;
+			FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(TraversalGraphBake), false, Source.Actor);
+			TraceParams.AddIgnoredActor(Target.Actor);
+			if(World->LineTraceTestByChannel(Source.Location, GrapplePoint, ECC_GameTraceChannel1, TraceParams)) continue;
+			const float TravelTime = FMath::Clamp(GrappleDistance / FMath::Max(Movement->GrappleSpeed, 1.f), Movement->MinGrappleDuration, Movement->MaxGrappleDuration);
+			Source.AddEdge(To, ETraversalEdgeType::Grapple, GrapplePrepareTime + TravelTime);
+		}
+	}
+
+	// Flatten into one edge array indexed by range per node
+	Graph->Nodes.Reset(Nodes.Num());
+	Graph->Edges.Reset();
+	Graph->HeuristicSpeed = 1.f;
+	for(const FBakeNode& Node : Nodes)
+	{
+		FTraversalGraphNode& GraphNode = Graph->Nodes.AddDefaulted_GetRef();
+		GraphNode.Location = Node.Location;
+		GraphNode.Type = Node.Type;
+		GraphNode.Actor = Node.Actor;
+		GraphNode.FirstEdge = Graph->Edges.Num();
+		GraphNode.NumEdges = Node.Edges.Num();
+		Graph->Edges.Append(Node.Edges);
+		for(const FTraversalGraphEdge& Edge : Node.Edges)
+		{
+			const float Speed = FVector::Dist(Node.Location, Nodes[Edge.To].Location) / FMath::Max(Edge.Cost, KINDA_SMALL_NUMBER);
+			Graph->HeuristicSpeed = FMath::Max(Graph->HeuristicSpeed, Speed);
+		}
+	}
+}
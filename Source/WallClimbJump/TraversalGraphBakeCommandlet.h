@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TraversalGraphBakeCommandlet.generated.h"
+
+/**
+ * Bakes the walls and ledges of a map, and the shimmy, hop, climb-up and grapple moves between
+ * them, into a UTraversalGraph saved next to the other graphs under /Game/TraversalGraphs.
+ *
+ * Grapple edges reach as far as the character's GrappleRange, or -GrappleRange when given. An unbounded range
+ * bakes them up to 5000 units instead so the graph doesn't connect every pair of ledges.
+ *
+ * UE4Editor-Cmd WallClimbJump.uproject -run=TraversalGraphBake -Map=/Game/ThirdPersonCPP/Maps/ThirdPersonExampleMap [-GrappleRange=3000]
+ */
+UCLASS()
+class WALLCLIMBJUMP_API UTraversalGraphBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTraversalGraphBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	bool BakeMap(const FString& MapPackageName, float GrappleRange) const;
+	void BuildGraph(UWorld* World, class UTraversalGraph* Graph, float GrappleRange) const;
+};
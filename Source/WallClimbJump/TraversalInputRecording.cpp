@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TraversalInputRecording.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace TraversalInputRecording
+{
+	/** "TRIN" */
+	constexpr uint32 Magic = 0x4E495254;
+	constexpr uint32 Version = 2;
+	/** Smallest a serialized frame can be, used to reject frame counts a file can't hold */
+	constexpr int64 MinFrameSize = 8;
+}
+
+bool FTraversalInputRecording::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	// Saving leaves the recording untouched
+	const_cast<FTraversalInputRecording*>(this)->Serialize(Writer);
+	return !Writer.IsError() && FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FTraversalInputRecording::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if(!FFileHelper::LoadFileToArray(Bytes, *Filename, FILEREAD_Silent)) return false;
+	FMemoryReader Reader(Bytes);
+	Serialize(Reader);
+	return !Reader.IsError();
+}
+
+FString FTraversalInputRecording::GetRecordingPath(const FString& Name)
+{
+	return FPaths::ProfilingDir() / TEXT("TraversalRecordings") / Name + TEXT(".tinput");
+}
+
+void FTraversalInputRecording::Serialize(FArchive& Ar)
+{
+	uint32 Magic = TraversalInputRecording::Magic;
+	uint32 Version = TraversalInputRecording::Version;
+	Ar << Magic << Version;
+	if(Magic != TraversalInputRecording::Magic || Version != TraversalInputRecording::Version)
+	{
+		Ar.SetError();
+		return;
+	}
+	Ar << MapName << StartLocation << StartRotation << EndLocation;
+
+	int32 NumFrames = Frames.Num();
+	Ar << NumFrames;
+	if(Ar.IsLoading())
+	{
+		if(NumFrames < 0 || NumFrames * TraversalInputRecording::MinFrameSize > Ar.TotalSize() - Ar.Tell())
+		{
+			Ar.SetError();
+			return;
+		}
+		Frames.SetNum(NumFrames);
+	}
+
+	// Timestamps are whole microseconds since the previous frame, taken from the rounded total so the error doesn't build up
+	uint64 Micros = 0;
+	for(FTraversalInputFrame& Frame : Frames)
+	{
+		uint32 Delta = 0;
+		if(Ar.IsSaving())
+		{
+			Delta = static_cast<uint32>(FMath::Max<int64>(static_cast<int64>(FMath::RoundToDouble(Frame.Time * 1000000.0)) - Micros, 0));
+		}
+		Ar.SerializeIntPacked(Delta);
+		Micros += Delta;
+		uint8 Actions = static_cast<uint8>(Frame.Actions);
+		Ar << Actions << Frame.Forward << Frame.Right << Frame.ControlYaw << Frame.ControlPitch;
+		if(Ar.IsLoading())
+		{
+			Frame.Time = Micros / 1000000.0;
+			Frame.Actions = static_cast<ETraversalInputAction>(Actions);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Actions bound in AWallClimbJumpCharacter::SetupPlayerInputComponent */
+enum class ETraversalInputAction : uint8
+{
+	None = 0,
+	Jump = 1 << 0,
+	StopJumping = 1 << 1,
+	Climb = 1 << 2,
+	Grapple = 1 << 3
+};
+ENUM_CLASS_FLAGS(ETraversalInputAction);
+
+/** Player input for one frame, axes are quantized to a byte and the control rotation to two per axis */
+struct FTraversalInputFrame
+{
+	/** Seconds from the start of the recording to the start of this frame */
+	double Time = 0.0;
+	/** Actions pressed or released this frame */
+	ETraversalInputAction Actions = ETraversalInputAction::None;
+	int8 Forward = 0;
+	int8 Right = 0;
+	uint16 ControlYaw = 0;
+	uint16 ControlPitch = 0;
+
+	void SetForward(const float Value) { Forward = QuantizeAxis(Value); }
+	void SetRight(const float Value) { Right = QuantizeAxis(Value); }
+	float GetForward() const { return Forward / 127.f; }
+	float GetRight() const { return Right / 127.f; }
+
+	void SetControlRotation(const FRotator& Rotation)
+	{
+		ControlYaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+		ControlPitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+	}
+	FRotator GetControlRotation() const { return FRotator(FRotator::DecompressAxisFromShort(ControlPitch), FRotator::DecompressAxisFromShort(ControlYaw), 0.f); }
+
+	static int8 QuantizeAxis(const float Value) { return static_cast<int8>(FMath::RoundToInt(FMath::Clamp(Value, -1.f, 1.f) * 127.f)); }
+};
+
+/**
+ * Inputs captured from a locally controlled AWallClimbJumpCharacter, for the TraversalBenchmark commandlet
+ * to replay at a fixed timestep. Saved as a short header followed by about eight bytes per frame.
+ */
+struct WALLCLIMBJUMP_API FTraversalInputRecording
+{
+	/** Long package name of the map the recording was made in */
+	FString MapName;
+	FVector StartLocation = FVector::ZeroVector;
+	FRotator StartRotation = FRotator::ZeroRotator;
+	/** Where the character was when recording stopped, a replay should end up here too */
+	FVector EndLocation = FVector::ZeroVector;
+	TArray<FTraversalInputFrame> Frames;
+
+	bool SaveToFile(const FString& Filename) const;
+	bool LoadFromFile(const FString& Filename);
+
+	/** Where a recording saved or replayed by name lives */
+	static FString GetRecordingPath(const FString& Name);
+
+private:
+	void Serialize(FArchive& Ar);
+};
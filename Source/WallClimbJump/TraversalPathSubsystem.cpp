@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TraversalPathSubsystem.h"
+
+#include "WallClimbJump.h"
+#include "Algo/Reverse.h"
+#include "Async/Async.h"
+#include "Misc/PackageName.h"
+#include "Misc/ScopeRWLock.h"
+
+/** Read-only copy of a graph that background queries can share, together with their path cache */
+class FTraversalGraphSnapshot
+{
+public:
+	explicit FTraversalGraphSnapshot(const UTraversalGraph& Graph)
+		: Edges(Graph.Edges)
+		, HeuristicSpeed(FMath::Max(Graph.HeuristicSpeed, 1.f))
+	{
+		Nodes.Reserve(Graph.Nodes.Num());
+		for(const FTraversalGraphNode& Node : Graph.Nodes)
+		{
+			const int32 Index = Nodes.Add({Node.Location, Node.Type, Node.FirstEdge, Node.NumEdges});
+			const FIntPoint Cell = ToCell(Node.Location);
+			NodeCells.FindOrAdd(Cell).Add(Index);
+			MinCell = Index == 0 ? Cell : FIntPoint(FMath::Min(MinCell.X, Cell.X), FMath::Min(MinCell.Y, Cell.Y));
+			MaxCell = Index == 0 ? Cell : FIntPoint(FMath::Max(MaxCell.X, Cell.X), FMath::Max(MaxCell.Y, Cell.Y));
+		}
+	}
+
+	FTraversalPathPtr FindPath(const FVector& Start, const FVector& Goal);
+
+private:
+	struct FNode
+	{
+		FVector Location;
+		ETraversalNodeType Type;
+		int32 FirstEdge;
+		int32 NumEdges;
+	};
+
+	/** Edges are only baked onto ledges, so a goal has to snap to one to be reachable */
+	int32 FindNearestNode(const FVector& Location, bool bLedgesOnly) const;
+	FIntPoint ToCell(const FVector& Location) const { return FIntPoint(FMath::FloorToInt(Location.X / NodeCellSize), FMath::FloorToInt(Location.Y / NodeCellSize)); }
+	FTraversalPathPtr Plan(int32 StartNode, int32 GoalNode) const;
+	float Heuristic(const int32 Node, const int32 GoalNode) const { return FVector::Dist(Nodes[Node].Location, Nodes[GoalNode].Location) / HeuristicSpeed; }
+
+	/** Cleared when full rather than evicted, paths are cheap to replan */
+	static constexpr int32 MaxCachedPaths = 4096;
+	static constexpr float NodeCellSize = 1000.f;
+
+	TArray<FNode> Nodes;
+	/** Node indices bucketed by XY cell, MinCell and MaxCell bound the occupied cells */
+	TMap<FIntPoint, TArray<int32>> NodeCells;
+	FIntPoint MinCell = FIntPoint::ZeroValue;
+	FIntPoint MaxCell = FIntPoint::ZeroValue;
+	const TArray<FTraversalGraphEdge> Edges;
+	const float HeuristicSpeed;
+	FRWLock CacheLock;
+	TMap<uint64, FTraversalPathPtr> Cache;
+};
+
+FTraversalPathPtr FTraversalGraphSnapshot::FindPath(const FVector& Start, const FVector& Goal)
+{
+	TRAVERSAL_SCOPE_CYCLE_COUNTER(STAT_TraversalPathQuery);
+	const int32 StartNode = FindNearestNode(Start, false);
+	const int32 GoalNode = FindNearestNode(Goal, true);
+	if(StartNode == INDEX_NONE || GoalNode == INDEX_NONE) return MakeShared<FTraversalPath, ESPMode::ThreadSafe>();
+
+	const uint64 Key = static_cast<uint64>(StartNode) << 32 | static_cast<uint32>(GoalNode);
+	{
+		FRWScopeLock ReadLock(CacheLock, SLT_ReadOnly);
+		if(const FTraversalPathPtr* Cached = Cache.Find(Key))
+		{
+			return *Cached;
+		}
+	}
+
+	FTraversalPathPtr Path = Plan(StartNode, GoalNode);
+	FRWScopeLock WriteLock(CacheLock, SLT_Write);
+	if(Cache.Num() >= MaxCachedPaths)
+	{
+		Cache.Reset();
+	}
+	Cache.Add(Key, Path);
+	return Path;
+}
+
+int32 FTraversalGraphSnapshot::FindNearestNode(const FVector& Location, const bool bLedgesOnly) const
+{
+	int32 Nearest = INDEX_NONE;
+	float NearestDistSquared = TNumericLimits<float>::Max();
+	const auto VisitCell = [this, &Location, bLedgesOnly, &Nearest, &NearestDistSquared](const int32 X, const int32 Y)
+	{
+		if(X < MinCell.X || X > MaxCell.X || Y < MinCell.Y || Y > MaxCell.Y) return;
+		const TArray<int32>* Cell = NodeCells.Find(FIntPoint(X, Y));
+		if(!Cell) return;
+		for(const int32 Index : *Cell)
+		{
+			if(bLedgesOnly && Nodes[Index].Type != ETraversalNodeType::Ledge) continue;
+			const float DistSquared = FVector::DistSquared(Location, Nodes[Index].Location);
+			// Lowest index on a tie, like a scan in node order
+			if(DistSquared < NearestDistSquared || (DistSquared == NearestDistSquared && Index < Nearest))
+			{
+				NearestDistSquared = DistSquared;
+				Nearest = Index;
+			}
+		}
+	};
+
+	// Rings of cells outward from the location's own, rings before StartRing lie wholly outside the occupied cells
+	const FIntPoint Origin = ToCell(Location);
+	const int32 StartRing = FMath::Max(FMath::Max3(0, MinCell.X - Origin.X, Origin.X - MaxCell.X), FMath::Max(MinCell.Y - Origin.Y, Origin.Y - MaxCell.Y));
+	const int32 EndRing = FMath::Max(FMath::Max(FMath::Abs(Origin.X - MinCell.X), FMath::Abs(Origin.X - MaxCell.X)), FMath::Max(FMath::Abs(Origin.Y - MinCell.Y), FMath::Abs(Origin.Y - MaxCell.Y)));
+	for(int32 Ring = StartRing; Ring <= EndRing; ++Ring)
+	{
+		// Everything in this ring and beyond is at least this far away horizontally
+		if(Nearest != INDEX_NONE && FMath::Square(FMath::Max(Ring - 1, 0) * NodeCellSize) > NearestDistSquared) break;
+		if(Ring == 0)
+		{
+			VisitCell(Origin.X, Origin.Y);
+			continue;
+		}
+		for(int32 Offset = -Ring; Offset <= Ring; ++Offset)
+		{
+			VisitCell(Origin.X + Offset, Origin.Y - Ring);
+			VisitCell(Origin.X + Offset, Origin.Y + Ring);
+		}
+		for(int32 Offset = -Ring + 1; Offset < Ring; ++Offset)
+		{
+			VisitCell(Origin.X - Ring, Origin.Y + Offset);
+			VisitCell(Origin.X + Ring, Origin.Y + Offset);
+		}
+	}
+	return Nearest;
+}
+
+FTraversalPathPtr FTraversalGraphSnapshot::Plan(const int32 StartNode, const int32 GoalNode) const
+{
+	struct FOpenNode
+	{
+		float Priority;
+		int32 Node;
+	};
+	const auto Cheaper = [](const FOpenNode& A, const FOpenNode& B) { return A.Priority < B.Priority; };
+
+	TArray<float> CostSoFar;
+	CostSoFar.Init(TNumericLimits<float>::Max(), Nodes.Num());
+	TArray<int32> CameFrom;
+	CameFrom.Init(INDEX_NONE, Nodes.Num());
+	TArray<ETraversalEdgeType> CameBy;
+	CameBy.SetNumUninitialized(Nodes.Num());
+	TArray<FOpenNode> Open;
+
+	CostSoFar[StartNode] = 0.f;
+	Open.HeapPush({Heuristic(StartNode, GoalNode), StartNode}, Cheaper);
+	while(Open.Num() > 0)
+	{
+		FOpenNode Current;
+		Open.HeapPop(Current, Cheaper, false);
+		if(Current.Node == GoalNode) break;
+		// Left behind when the node was reached more cheaply later
+		const float CurrentCost = CostSoFar[Current.Node];
+		if(Current.Priority > CurrentCost + Heuristic(Current.Node, GoalNode) + KINDA_SMALL_NUMBER) continue;
+
+		const FNode& Node = Nodes[Current.Node];
+		for(int32 EdgeIndex = Node.FirstEdge; EdgeIndex < Node.FirstEdge + Node.NumEdges; ++EdgeIndex)
+		{
+			const FTraversalGraphEdge& Edge = Edges[EdgeIndex];
+			const float NewCost = CurrentCost + Edge.Cost;
+			if(NewCost >= CostSoFar[Edge.To]) continue;
+			CostSoFar[Edge.To] = NewCost;
+			CameFrom[Edge.To] = Current.Node;
+			CameBy[Edge.To] = Edge.Type;
+			Open.HeapPush({NewCost + Heuristic(Edge.To, GoalNode), Edge.To}, Cheaper);
+		}
+	}
+
+	TSharedRef<FTraversalPath, ESPMode::ThreadSafe> Path = MakeShared<FTraversalPath, ESPMode::ThreadSafe>();
+	if(GoalNode != StartNode && CameFrom[GoalNode] == INDEX_NONE) return Path;
+	for(int32 Node = GoalNode; Node != INDEX_NONE; Node = CameFrom[Node])
+	{
+		Path->Nodes.Add(Node);
+	}
+	Algo::Reverse(Path->Nodes);
+	for(int32 Index = 0; Index < Path->Nodes.Num(); ++Index)
+	{
+		const int32 Node = Path->Nodes[Index];
+		Path->Points.Add(Nodes[Node].Location);
+		if(Index > 0)
+		{
+			Path->Moves.Add(CameBy[Node]);
+		}
+	}
+	Path->Cost = CostSoFar[GoalNode];
+	return Path;
+}
+
+void UTraversalPathSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	// Graphs are baked per map under a fixed name, a missing one just leaves AI without routes
+	const FString PackageName = UTraversalGraph::GetPackageNameForMap(UWorld::RemovePIEPrefix(InWorld.GetOutermost()->GetName()));
+	if(FPackageName::DoesPackageExist(PackageName))
+	{
+		SetGraph(LoadObject<UTraversalGraph>(nullptr, *(PackageName + TEXT(".") + FPackageName::GetShortName(PackageName))));
+	}
+}
+
+void UTraversalPathSubsystem::Deinitialize()
+{
+	Graph = nullptr;
+	Snapshot.Reset();
+	Super::Deinitialize();
+}
+
+void UTraversalPathSubsystem::SetGraph(UTraversalGraph* InGraph)
+{
+	LLM_SCOPE_BYTAG(Traversal);
+	Graph = InGraph;
+	// Queries still running keep the old snapshot alive until they finish
+	Snapshot.Reset();
+	if(Graph)
+	{
+		Snapshot = MakeShared<FTraversalGraphSnapshot, ESPMode::ThreadSafe>(*Graph);
+	}
+}
+
+void UTraversalPathSubsystem::FindPathAsync(const FVector& Start, const FVector& Goal, FOnTraversalPathFound OnFound) const
+{
+	if(!Snapshot)
+	{
+		OnFound.ExecuteIfBound(nullptr);
+		return;
+	}
+	TSharedPtr<FTraversalGraphSnapshot, ESPMode::ThreadSafe> Query = Snapshot;
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Query, Start, Goal, OnFound]()
+	{
+		FTraversalPathPtr Path = Query->FindPath(Start, Goal);
+		AsyncTask(ENamedThreads::GameThread, [OnFound, Path]()
+		{
+			OnFound.ExecuteIfBound(Path);
+		});
+	});
+}
+
+FTraversalPathPtr UTraversalPathSubsystem::FindPath(const FVector& Start, const FVector& Goal) const
+{
+	if(!Snapshot) return nullptr;
+	return Snapshot->FindPath(Start, Goal);
+}
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TraversalGraph.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TraversalPathSubsystem.generated.h"
+
+/** Route through a traversal graph, empty when the goal can't be reached */
+struct FTraversalPath
+{
+	/** Graph nodes from start to goal */
+	TArray<int32> Nodes;
+	TArray<FVector> Points;
+	/** Move taken into each node after the first */
+	TArray<ETraversalEdgeType> Moves;
+	/** Seconds the whole route takes */
+	float Cost = 0.f;
+
+	bool IsValid() const { return Nodes.Num() > 0; }
+};
+
+using FTraversalPathPtr = TSharedPtr<const FTraversalPath, ESPMode::ThreadSafe>;
+
+DECLARE_DELEGATE_OneParam(FOnTraversalPathFound, FTraversalPathPtr);
+
+/**
+ * Plans routes over the map's baked UTraversalGraph for AI. Queries run A* on background tasks
+ * against an immutable copy of the graph, and results are cached per start and goal node.
+ */
+UCLASS()
+class WALLCLIMBJUMP_API UTraversalPathSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** Replaces the graph baked for this map, dropping cached paths */
+	void SetGraph(UTraversalGraph* InGraph);
+	UTraversalGraph* GetGraph() const { return Graph; }
+
+	/** Plans from the node nearest Start to the ledge node nearest Goal off the game thread, OnFound runs on the game thread */
+	void FindPathAsync(const FVector& Start, const FVector& Goal, FOnTraversalPathFound OnFound) const;
+	/** Blocking version of FindPathAsync, null when there is no graph */
+	FTraversalPathPtr FindPath(const FVector& Start, const FVector& Goal) const;
+
+private:
+	UPROPERTY()
+	UTraversalGraph* Graph;
+	TSharedPtr<class FTraversalGraphSnapshot, ESPMode::ThreadSafe> Snapshot;
+};
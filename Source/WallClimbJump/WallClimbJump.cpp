@@ -4,4 +4,24 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, WallClimbJump, "WallClimbJump" );
- 
\ No newline at end of file
+
+DEFINE_LOG_CATEGORY(LogTraversal);
+
+UE_TRACE_CHANNEL_DEFINE(TraversalChannel);
+
+DEFINE_STAT(STAT_TraversalTick);
+DEFINE_STAT(STAT_TraversalLocateTarget);
+DEFINE_STAT(STAT_TraversalLedgeSweep);
+DEFINE_STAT(STAT_TraversalWallTrace);
+DEFINE_STAT(STAT_TraversalShimmyTrace);
+DEFINE_STAT(STAT_TraversalPathQuery);
+DEFINE_STAT(STAT_TraversalScoreTargetsParallel);
+DEFINE_STAT(STAT_TraversalTracesIssued);
+DEFINE_STAT(STAT_TraversalLedgesEvaluated);
+DEFINE_STAT(STAT_TraversalLLM);
+DEFINE_STAT(STAT_TraversalSummaryLLM);
+
+LLM_DEFINE_TAG(Traversal, NAME_None, NAME_None, GET_STATFNAME(STAT_TraversalLLM), GET_STATFNAME(STAT_TraversalSummaryLLM));
+
+FTraversalFrameCounters GTraversalFrameCounters;
+int32 GTraversalAllocationScopeDepth = 0;
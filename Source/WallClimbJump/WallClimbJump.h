@@ -3,3 +3,86 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#if UE_BUILD_SHIPPING
+DECLARE_LOG_CATEGORY_EXTERN(LogTraversal, Log, NoLogging);
+#else
+DECLARE_LOG_CATEGORY_EXTERN(LogTraversal, Log, All);
+#endif
+
+// Enable with "-trace=cpu,Traversal" to see traversal scopes in Unreal Insights
+UE_TRACE_CHANNEL_EXTERN(TraversalChannel, WALLCLIMBJUMP_API);
+
+/** Object type of ledge collision proxies, see the LedgeProxy collision profile */
+#define COLLISION_LEDGE ECC_GameTraceChannel2
+
+DECLARE_STATS_GROUP(TEXT("Traversal"), STATGROUP_Traversal, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Tick"), STAT_TraversalTick, STATGROUP_Traversal, WALLCLIMBJUMP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Locate Target"), STAT_TraversalLocateTarget, STATGROUP_Traversal, WALLCLIMBJUMP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ledge Sweep"), STAT_TraversalLedgeSweep, STATGROUP_Traversal, WALLCLIMBJUMP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wall Trace"), STAT_TraversalWallTrace, STATGROUP_Traversal, WALLCLIMBJUMP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shimmy Traces"), STAT_TraversalShimmyTrace, STATGROUP_Traversal, WALLCLIMBJUMP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Path Query"), STAT_TraversalPathQuery, STATGROUP_Traversal, WALLCLIMBJUMP_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Score Targets Parallel"), STAT_TraversalScoreTargetsParallel, STATGROUP_Traversal, WALLCLIMBJUMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces Issued"), STAT_TraversalTracesIssued, STATGROUP_Traversal, WALLCLIMBJUMP_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ledges Evaluated"), STAT_TraversalLedgesEvaluated, STATGROUP_Traversal, WALLCLIMBJUMP_API);
+
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("Traversal"), STAT_TraversalLLM, STATGROUP_LLMFULL, WALLCLIMBJUMP_API);
+DECLARE_LLM_MEMORY_STAT_EXTERN(TEXT("Traversal"), STAT_TraversalSummaryLLM, STATGROUP_LLM, WALLCLIMBJUMP_API);
+
+// Memory allocated under LLM_SCOPE_BYTAG(Traversal) shows up in "stat llm" and "stat llmfull" when run with -llm
+LLM_DECLARE_TAG_API(Traversal, WALLCLIMBJUMP_API);
+
+/** Times the enclosing scope for both "stat Traversal" and the Insights traversal channel */
+#define TRAVERSAL_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, TraversalChannel)
+
+#define TRAVERSAL_COUNT_TRACE() do { INC_DWORD_STAT(STAT_TraversalTracesIssued); ++GTraversalFrameCounters.TracesIssued; } while(0)
+#define TRAVERSAL_COUNT_LEDGE() do { INC_DWORD_STAT(STAT_TraversalLedgesEvaluated); ++GTraversalFrameCounters.LedgesEvaluated; } while(0)
+/** Adds up ledges scored off the game thread, the frame counters are only touched on it */
+#define TRAVERSAL_COUNT_LEDGES(Num) do { INC_DWORD_STAT_BY(STAT_TraversalLedgesEvaluated, Num); GTraversalFrameCounters.LedgesEvaluated += Num; } while(0)
+
+/** Plain per-frame totals for tools that can't read the stats system, whoever consumes them resets them */
+struct FTraversalFrameCounters
+{
+	uint32 TracesIssued = 0;
+	uint32 LedgesEvaluated = 0;
+	/** Only counted while an allocation counting FMalloc is installed, see TRAVERSAL_SCOPE_ALLOCATIONS */
+	uint32 Allocations = 0;
+	uint64 TickCycles = 0;
+	uint64 LocateTargetCycles = 0;
+
+	void Reset() { *this = FTraversalFrameCounters(); }
+};
+
+extern WALLCLIMBJUMP_API FTraversalFrameCounters GTraversalFrameCounters;
+
+struct FTraversalCycleAccumulator
+{
+	explicit FTraversalCycleAccumulator(uint64& InTotal) : Total(InTotal), StartCycles(FPlatformTime::Cycles64()) {}
+	~FTraversalCycleAccumulator() { Total += FPlatformTime::Cycles64() - StartCycles; }
+
+	uint64& Total;
+	uint64 StartCycles;
+};
+
+/** Adds the enclosing scope's time to the named GTraversalFrameCounters field */
+#define TRAVERSAL_SCOPE_FRAME_TIMER(Field) FTraversalCycleAccumulator PREPROCESSOR_JOIN(TraversalFrameTimer, __LINE__)(GTraversalFrameCounters.Field)
+
+/** Nesting depth of TRAVERSAL_SCOPE_ALLOCATIONS on the game thread */
+extern WALLCLIMBJUMP_API int32 GTraversalAllocationScopeDepth;
+
+struct FTraversalAllocationScope
+{
+	FTraversalAllocationScope() { ++GTraversalAllocationScopeDepth; }
+	~FTraversalAllocationScope() { --GTraversalAllocationScopeDepth; }
+};
+
+/** Marks the enclosing game thread scope as a hot path that should not allocate */
+#define TRAVERSAL_SCOPE_ALLOCATIONS() FTraversalAllocationScope PREPROCESSOR_JOIN(TraversalAllocationScope, __LINE__)
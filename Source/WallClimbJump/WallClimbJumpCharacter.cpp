@@ -2,26 +2,146 @@
 
 #include "WallClimbJumpCharacter.h"
 
+#include "WallClimbJump.h"
 #include "CableComponent.h"
 #include "CharAnimInstance.h"
 #include "ClimbableWall.h"
+#include "ClimbMovementComponent.h"
 // #include "DrawDebugHelpers.h"
-#include "EngineUtils.h"
 #include "GrappleTarget.h"
 #include "Ledge.h"
+#include "LedgeSubsystem.h"
 #include "UIWidget.h"
+#include "Async/ParallelFor.h"
 #include "Camera/CameraComponent.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Net/UnrealNetwork.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "UObject/ConstructorHelpers.h"
+
+#define LOCTEXT_NAMESPACE "WallClimbJumpCharacter"
+
+static TAutoConsoleVariable<int32> CVarTraversalAsyncTraces(
+	TEXT("traversal.AsyncTraces"),
+	0,
+	TEXT("Submit the character's ledge, wall and shimmy traces asynchronously and apply the results next frame.\n")
+	TEXT("0: synchronous traces (default)\n")
+	TEXT("1: async traces with one frame of latency"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarTraversalParallelTargetThreshold(
+	TEXT("traversal.ParallelTargetThreshold"),
+	512,
+	TEXT("Score the rest of a grapple target sweep on worker threads in one frame once at least this many ledges are left.\n")
+	TEXT("0 always scores on the game thread"),
+	ECVF_Default);
+
+/** Shortest gap between traversal state updates an owning client sends, shimmying can change it every frame */
+static constexpr float TraversalStateSendInterval = 0.1f;
+
+/** Slack on top of GrappleRange for the server's reach check, the client picked its target from a slightly different spot */
+static constexpr float GrappleReachTolerance = 100.f;
+
+/** StartGrapple fires the cable and then launches after these many seconds */
+static constexpr float GrappleCableDelay = 1.f;
+static constexpr float GrappleLaunchDelay = 3.f;
+
+/** Fewest candidates worth handing to one worker */
+static constexpr int32 MinTargetScoringChunk = 64;
+
+/**
+ * The serial scan keeps the last of equally close candidates. Preferring the higher sweep index on a
+ * tie gives the same winner whatever order chunk results are combined in.
+ */
+static bool IsBetterTargetCandidate(const float Distance, const int32 Index, const float BestDistance, const int32 BestIndex)
+{
+	return BestIndex == INDEX_NONE || Distance < BestDistance || (Distance == BestDistance && Index > BestIndex);
+}
+
+static AWallClimbJumpCharacter* GetLocalTraversalCharacter(const UWorld* World)
+{
+	const APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+	return PlayerController ? Cast<AWallClimbJumpCharacter>(PlayerController->GetPawn()) : nullptr;
+}
+
+static FAutoConsoleCommandWithWorld CmdTraversalRecordInput(
+	TEXT("traversal.RecordInput"),
+	TEXT("Starts recording the local character's traversal input for the TraversalBenchmark commandlet to replay"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if(AWallClimbJumpCharacter* Character = GetLocalTraversalCharacter(World))
+		{
+			Character->StartInputRecording();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdTraversalStopRecordingInput(
+	TEXT("traversal.StopRecordingInput"),
+	TEXT("Saves the traversal input recording under Saved/Profiling/TraversalRecordings.\n")
+	TEXT("Takes an optional recording name, the current date and time otherwise"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		AWallClimbJumpCharacter* Character = GetLocalTraversalCharacter(World);
+		if(Character && Character->IsRecordingInput())
+		{
+			Character->StopInputRecording(FTraversalInputRecording::GetRecordingPath(Args.Num() > 0 ? Args[0] : FDateTime::Now().ToString()));
+		}
+	}));
+
+bool FTraversalRepState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// State, rotation flag and shimmy direction fit in six bits
+	uint8 Packed = static_cast<uint8>(State) | (bIsRotating ? 1 << 3 : 0) | static_cast<uint8>(ShimmyDirection + 1) << 4;
+	Ar.SerializeBits(&Packed, 6);
+	if(Ar.IsLoading())
+	{
+		*this = FTraversalRepState();
+		State = static_cast<ETraversalState>(FMath::Min<uint8>(Packed & 7, static_cast<uint8>(ETraversalState::MAX) - 1));
+		bIsRotating = (Packed & 1 << 3) != 0;
+		ShimmyDirection = static_cast<int8>(FMath::Min((Packed >> 4) & 3, 2)) - 1;
+	}
+	bOutSuccess = true;
+	if(State == ETraversalState::None) return true;
+
+	bool bLocalSuccess = true;
+	SurfaceNormal.NetSerialize(Ar, Map, bLocalSuccess);
+	bOutSuccess &= bLocalSuccess;
+	if(State == ETraversalState::GrapplePreparing || State == ETraversalState::Grappling)
+	{
+		GrapplePoint.NetSerialize(Ar, Map, bLocalSuccess);
+		bOutSuccess &= bLocalSuccess;
+	}
+	if(State == ETraversalState::Grappling)
+	{
+		uint16 DurationMs = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(GrappleDuration * 1000.f), 0, MAX_uint16));
+		Ar << DurationMs;
+		GrappleDuration = DurationMs / 1000.f;
+	}
+	if(State != ETraversalState::Climbing)
+	{
+		UObject* Object = Ledge;
+		bOutSuccess &= Map->SerializeObject(Ar, ALedge::StaticClass(), Object);
+		Ledge = Cast<ALedge>(Object);
+	}
+	return true;
+}
 
 //////////////////////////////////////////////////////////////////////////
 // AWallClimbJumpCharacter
 
-AWallClimbJumpCharacter::AWallClimbJumpCharacter()
+AWallClimbJumpCharacter::AWallClimbJumpCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer
+		.SetDefaultSubobjectClass<UClimbMovementComponent>(ACharacter::CharacterMovementComponentName)
+		.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName))
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
@@ -38,11 +158,15 @@ AWallClimbJumpCharacter::AWallClimbJumpCharacter()
 	bUseControllerRotationRoll = false;
 
 	// Configure character movement
+	ClimbMovement = Cast<UClimbMovementComponent>(GetCharacterMovement());
 	GetCharacterMovement()->bOrientRotationToMovement = true; // Character moves in the direction of input...	
 	GetCharacterMovement()->RotationRate = FRotator(0.0f, 540.0f, 0.0f); // ...at this rotation rate
 	GetCharacterMovement()->JumpZVelocity = 600.f;
 	GetCharacterMovement()->AirControl = 0.2f;
 
+	// URO is what BeginPlay tunes, and the fallback when the budget allocator is off
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+
 	// Create a camera boom (pulls in towards the player if there is a collision)
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
 	CameraBoom->SetupAttachment(RootComponent);
@@ -57,120 +181,132 @@ AWallClimbJumpCharacter::AWallClimbJumpCharacter()
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 	CableComponent = CreateDefaultSubobject<UCableComponent>("Cable");
-	CableComponent->NumSegments = 1;
+	// Only simulated while slack, they are only allocated on register so the count never changes afterwards
+	CableComponent->NumSegments = 8;
 	CableComponent->CableLength = 20;
 	CableComponent->CableWidth = 5;
+	// Asleep until a grapple fires it, see WakeCable
+	CableComponent->PrimaryComponentTick.bStartWithTickEnabled = false;
+	CableComponent->bSkipCableUpdateWhenNotOwnerRecentlyRendered = true;
+	CableComponent->SetVisibility(false);
+
+	// Drawn instead of the cable once the pull starts, a taut rope is a straight line with nothing to simulate
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> CylinderMesh(TEXT("/Engine/BasicShapes/Cylinder.Cylinder"));
+	TautCableMesh = CreateDefaultSubobject<UStaticMeshComponent>("TautCable");
+	TautCableMesh->SetupAttachment(RootComponent);
+	TautCableMesh->SetStaticMesh(CylinderMesh.Object);
+	TautCableMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	TautCableMesh->SetGenerateOverlapEvents(false);
+	TautCableMesh->SetCastShadow(false);
+	TautCableMesh->SetVisibility(false);
 
 }
 
 void AWallClimbJumpCharacter::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Traversal);
 	CableComponent->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, "grapple_Socket");
+	TautCableMesh->SetMaterial(0, CableComponent->GetMaterial(0));
 	HoldOffset = UKismetMathLibrary::MakeRelativeTransform(GetActorTransform(), GetMesh()->GetSocketTransform("hang_Socket")).GetLocation();
 	Super::BeginPlay();
-	if(PromptWidgetClass)
+	// Headless worlds have no player to own the prompt widget
+	if(PromptWidgetClass && GetWorld()->GetFirstPlayerController())
 	{
 		UUserWidget* UserWidget = CreateWidget(GetWorld()->GetFirstPlayerController(), PromptWidgetClass);
-		if(!UserWidget) return;
-		UserWidget->AddToViewport(0);
-		PromptWidget = Cast<UUIWidget>(UserWidget);		
+		if(UserWidget)
+		{
+			UserWidget->AddToViewport(0);
+			PromptWidget = Cast<UUIWidget>(UserWidget);
+		}
 	}
-	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-	if(AnimInstance)
+	if(GrappleMarkerMode == EGrappleMarkerMode::Actor && TargetActorClass)
 	{
-		AnimController = Cast<UCharAnimInstance>(AnimInstance);
+		TargetActor = Cast<AGrappleTarget>(GetWorld()->SpawnActor(TargetActorClass));
+		bTargetMarkerVisible = true;
+		SetTargetMarkerVisible(false);
 	}
-	if(TargetActorClass)
+	// Built once, every traversal trace ignores the same two actors
+	TraversalQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(TraversalTrace), false, this);
+	TraversalQueryParams.AddIgnoredActor(TargetActor);
+	LedgeObjectParams = FCollisionObjectQueryParams(COLLISION_LEDGE);
+	LedgeRegistry = GetWorld()->GetSubsystem<ULedgeSubsystem>();
+	LedgeSweepDelegate.BindUObject(this, &AWallClimbJumpCharacter::OnLedgeSweepDone);
+	WallTraceDelegate.BindUObject(this, &AWallClimbJumpCharacter::OnWallTraceDone);
+	ShimmyTraceDelegate.BindUObject(this, &AWallClimbJumpCharacter::OnShimmyTraceDone);
+	if(FAnimUpdateRateParameters* RateParams = GetMesh()->AnimUpdateRateParams)
 	{
-		TargetActor = Cast<AGrappleTarget>(GetWorld()->SpawnActor(TargetActorClass));
+		// Plain URO when the budget allocator is off, skip more frames the smaller the mesh is on screen
+		RateParams->BaseVisibleDistanceFactorThesholds = {0.4f, 0.2f, 0.1f};
+		RateParams->BaseNonRenderedUpdateRate = 4;
+		RateParams->MaxEvalRateForInterpolation = 4;
+		RateParams->bInterpolateSkippedFrames = true;
 	}
-	for(TActorIterator<ALedge> It(GetWorld()); It; ++It)
+	ClimbMovement->OnGrappleArrived.AddUObject(this, &AWallClimbJumpCharacter::OnGrappleArrived);
+	// The server holds remote clients to the same range their targets are picked in, without one it keeps the component's limit
+	if(GrappleRange > 0.f)
 	{
-		ALedge* Ledge = *It;
-		Ledges.Add(Ledge);
+		ClimbMovement->MaxGrappleDistance = GrappleRange + GrappleReachTolerance;
 	}
 }
 
 void AWallClimbJumpCharacter::Tick(float DeltaTime)
 {
+	TRAVERSAL_SCOPE_CYCLE_COUNTER(STAT_TraversalTick);
+	TRAVERSAL_SCOPE_FRAME_TIMER(TickCycles);
+	TRAVERSAL_SCOPE_ALLOCATIONS();
+	LLM_SCOPE_BYTAG(Traversal);
+	// Input for this frame has been processed by the time the controller lets the pawn tick
+	if(InputRecording)
+	{
+		RecordInputFrame(DeltaTime);
+	}
 	Super::Tick(DeltaTime);
-	if(!TargetActor) return;
-	if(bIsClimbing)
+	UpdateAnimationBudget(DeltaTime);
+	if(!IsLocallyControlled())
 	{
-		if(GetVelocity().IsZero())
+		// The controlling machine decides traversal, everyone else presents its replicated state
+		if(HasAuthority())
 		{
-			GetMesh()->GlobalAnimRateScale = 0.0f;
+			ResolveClientTraversalState();
+			UpdateAlignment();
 		}
-		else
+		if(bIsGrappling)
 		{
-			GetMesh()->GlobalAnimRateScale = 1.0f;
+			GrappleTravel(DeltaTime);
 		}
+		return;
 	}
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(this);
-	CollisionParams.AddIgnoredActor(TargetActor);
+	PublishTraversalState();
 	FVector ActorLoc = GetActorLocation();
 
-	if(bIsRotating && (bIsHoldingLedge && CurrentLedge || bIsClimbing || bIsGrapplePreparing))
+	UpdateAlignment();
+	if (bIsGrappling || bIsGrapplePreparing)
 	{
-		const float ForwardDotProduct = FVector::DotProduct(RotateNormal, GetActorRightVector());
-		UE_LOG(LogTemp, Warning, TEXT("Forward:%f"), ForwardDotProduct);
-		if(ForwardDotProduct < 0)
+		SetTargetMarkerVisible(false);
+		if(!bIsGrappling)
 		{
-			if(ForwardDotProduct > -0.010000)
-			{
-				bIsRotating = false;
-			}
-			else
-			{
-				FRotator CurrentRot = GetActorRotation();
-				SetActorRotation(CurrentRot.Add(0, 1, 0));
-			}
-		}else if(ForwardDotProduct > 0)
-		{
-			if(ForwardDotProduct < 0.010000)
-			{
-				bIsRotating = false;
-			}
-			else
-			{
-				FRotator CurrentRot = GetActorRotation();
-				SetActorRotation(CurrentRot.Add(0, -1, 0));
-			}
-		}else
-		{
-			bIsRotating = false;
+			AdvanceGrappleWindup(DeltaTime);
 		}
-	}
-	if (bIsGrappling || bIsGrapplePreparing)
-	{
-		TargetActor->ShowTarget(false);
 		GrappleTravel(DeltaTime);
 		return;
 	}
 	LocateTarget();
-	if(!bIsHoldingLedge)
+	if(!bIsHoldingLedge && ShouldSweepForLedges())
 	{
 		FVector StartPos = ActorLoc + GetActorForwardVector() * 40;
 		FVector EndPos = StartPos + GetActorUpVector() * 140;
 		// DrawDebugLine(GetWorld(), StartPos, EndPos, FColor::Red, false, -1, 0, 3);
-		FHitResult LedgeOutHit;
-		if(GetWorld()->SweepSingleByChannel(LedgeOutHit, StartPos, EndPos, GetActorRotation().Quaternion(), ECC_GameTraceChannel1, CapsuleCollisionShape, CollisionParams))
+		TRAVERSAL_SCOPE_CYCLE_COUNTER(STAT_TraversalLedgeSweep);
+		TRAVERSAL_COUNT_TRACE();
+		if(CVarTraversalAsyncTraces.GetValueOnGameThread())
 		{
-			ALedge* HitLedge = Cast<ALedge>(LedgeOutHit.Actor);
-			if(HitLedge)
-			{
-				SelectedLedge = HitLedge;
-				ShowPrompt("Space - Jump to Ledge");
-			}else
-			{
-				SelectedLedge = nullptr;
-				HidePrompt("Space - Jump to Ledge");
-			}
-		}else
+			GetWorld()->AsyncSweepByObjectType(EAsyncTraceType::Single, StartPos, EndPos, GetActorRotation().Quaternion(), LedgeObjectParams, CapsuleCollisionShape, TraversalQueryParams, &LedgeSweepDelegate);
+		}
+		else
 		{
-			SelectedLedge = nullptr;
-			HidePrompt("Space - Jump to Ledge");
+			FHitResult LedgeOutHit;
+			const bool bHit = GetWorld()->SweepSingleByObjectType(LedgeOutHit, StartPos, EndPos, GetActorRotation().Quaternion(), LedgeObjectParams, CapsuleCollisionShape, TraversalQueryParams);
+			HandleLedgeSweep(bHit, LedgeOutHit);
 		}
 		// DrawDebugCapsule(GetWorld(), StartPos + GetActorUpVector() * 70, 70, 14, GetActorRotation().Quaternion(), FColor::Green, false, -1, 0, 3);
 	}
@@ -203,8 +339,276 @@ void AWallClimbJumpCharacter::Tick(float DeltaTime)
 	// 	}
 	// }
 	// DrawDebugLine(GetWorld(), ActorLoc, ActorLoc + GetActorForwardVector() * 50, FColor::Green, false, -1, 0, 3);
-	FHitResult WallOutHit;
-	if(GetWorld()->LineTraceSingleByChannel(WallOutHit, ActorLoc, ActorLoc + GetActorForwardVector() * 50, ECC_WorldStatic, CollisionParams))
+	if(WallZones.Num() == 0)
+	{
+		// Nothing climbable nearby, the zones' overlap events wake the trace up again
+		return;
+	}
+	TRAVERSAL_SCOPE_CYCLE_COUNTER(STAT_TraversalWallTrace);
+	TRAVERSAL_COUNT_TRACE();
+	if(CVarTraversalAsyncTraces.GetValueOnGameThread())
+	{
+		GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, ActorLoc, ActorLoc + GetActorForwardVector() * 50, ECC_WorldStatic, TraversalQueryParams, FCollisionResponseParams::DefaultResponseParam, &WallTraceDelegate);
+	}
+	else
+	{
+		FHitResult WallOutHit;
+		const bool bHit = GetWorld()->LineTraceSingleByChannel(WallOutHit, ActorLoc, ActorLoc + GetActorForwardVector() * 50, ECC_WorldStatic, TraversalQueryParams);
+		HandleWallTrace(bHit, WallOutHit);
+	}
+}
+
+void AWallClimbJumpCharacter::UpdateAnimationBudget(const float DeltaTime)
+{
+	// Holding still on a wall keeps the last pose straight away, hanging waits for the grab to settle first
+	const bool bStill = GetVelocity().IsZero();
+	const bool bHangingIdle = bStill && bIsHoldingLedge && AnimState.Direction == 0;
+	HangIdleTime = bHangingIdle ? HangIdleTime + DeltaTime : 0.f;
+	SetPoseFrozen((bIsClimbing && bStill) || (bFreezePoseWhileHangingIdle && HangIdleTime >= HangIdleFreezeDelay));
+
+	USkeletalMeshComponentBudgeted* BudgetedMesh = Cast<USkeletalMeshComponentBudgeted>(GetMesh());
+	if(!BudgetedMesh || BudgetedMesh->bNoSkeletonUpdate) return;
+	float Significance = 1.f;
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if(PlayerController && PlayerController->PlayerCameraManager)
+	{
+		const float Distance = FVector::Dist(PlayerController->PlayerCameraManager->GetCameraLocation(), GetActorLocation());
+		Significance = FMath::Clamp(1.f - Distance / AnimationSignificanceRange, 0.f, 1.f);
+	}
+	// The local player's own climber is never throttled
+	BudgetedMesh->SetComponentSignificance(Significance, IsLocallyControlled() && IsPlayerControlled());
+}
+
+void AWallClimbJumpCharacter::SetPoseFrozen(const bool bFrozen)
+{
+	if(GetMesh()->bNoSkeletonUpdate == bFrozen) return;
+	GetMesh()->bNoSkeletonUpdate = bFrozen;
+}
+
+void AWallClimbJumpCharacter::UpdateAlignment()
+{
+	if(bIsRotating && (bIsHoldingLedge && CurrentLedge || bIsClimbing || bIsGrapplePreparing))
+	{
+		// The movement component turns towards the normal on its own fixed step
+		ClimbMovement->AlignToSurface(RotateNormal);
+		bIsRotating = ClimbMovement->IsAligning();
+	}
+	else
+	{
+		ClimbMovement->StopAligning();
+	}
+}
+
+void AWallClimbJumpCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	// The owner predicts its own traversal, so only simulated proxies need the state
+	DOREPLIFETIME_CONDITION(AWallClimbJumpCharacter, TraversalRepState, COND_SimulatedOnly);
+}
+
+ETraversalState AWallClimbJumpCharacter::GetTraversalState() const
+{
+	if(bIsGrappling) return ETraversalState::Grappling;
+	if(bIsGrapplePreparing) return ETraversalState::GrapplePreparing;
+	if(bIsHoldingLedge) return ETraversalState::Hanging;
+	if(bIsClimbing) return ETraversalState::Climbing;
+	return ETraversalState::None;
+}
+
+FTraversalRepState AWallClimbJumpCharacter::MakeTraversalRepState() const
+{
+	FTraversalRepState NewState;
+	NewState.State = GetTraversalState();
+	if(NewState.State == ETraversalState::None) return NewState;
+	NewState.bIsRotating = bIsRotating;
+	if(NewState.State == ETraversalState::GrapplePreparing || NewState.State == ETraversalState::Grappling)
+	{
+		NewState.SurfaceNormal = GrappleNormal;
+		NewState.GrapplePoint = GrapplePoint;
+		if(NewState.State == ETraversalState::Grappling)
+		{
+			NewState.GrappleDuration = ClimbMovement->GetGrappleTrajectory().Duration;
+		}
+		NewState.Ledge = TargetLedge;
+		return NewState;
+	}
+	NewState.SurfaceNormal = RotateNormal;
+	if(NewState.State == ETraversalState::Hanging)
+	{
+		NewState.Ledge = CurrentLedge;
+		NewState.ShimmyDirection = static_cast<int8>(FMath::Sign(AnimState.Direction));
+	}
+	return NewState;
+}
+
+void AWallClimbJumpCharacter::PublishTraversalState()
+{
+	const FTraversalRepState NewState = MakeTraversalRepState();
+	if(NewState == TraversalRepState) return;
+	if(!HasAuthority())
+	{
+		// Changes in between are folded into the next send, only the latest state matters
+		const float Now = GetWorld()->GetTimeSeconds();
+		if(Now < NextTraversalStateSendTime) return;
+		NextTraversalStateSendTime = Now + TraversalStateSendInterval;
+		ServerSetTraversalState(NewState);
+	}
+	TraversalRepState = NewState;
+}
+
+bool AWallClimbJumpCharacter::ServerSetTraversalState_Validate(const FTraversalRepState& NewState)
+{
+	return !NewState.SurfaceNormal.ContainsNaN() && !NewState.GrapplePoint.ContainsNaN() && FMath::IsFinite(NewState.GrappleDuration);
+}
+
+void AWallClimbJumpCharacter::ServerSetTraversalState_Implementation(const FTraversalRepState& NewState)
+{
+	ClientTraversalState = NewState;
+	ResolveClientTraversalState();
+}
+
+void AWallClimbJumpCharacter::ResolveClientTraversalState()
+{
+	// What the client is doing comes from the server's own movement, only presentation is taken from the client
+	FTraversalRepState State;
+	if(ClimbMovement->IsInCustomMode(CMOVE_Climb))
+	{
+		State.State = ETraversalState::Climbing;
+	}
+	else if(ClimbMovement->IsInCustomMode(CMOVE_Hang))
+	{
+		State.State = ETraversalState::Hanging;
+		State.Ledge = ClimbMovement->GetTraversalLedge();
+		State.ShimmyDirection = ClientTraversalState.State == ETraversalState::Hanging ? ClientTraversalState.ShimmyDirection : 0;
+	}
+	else if(ClimbMovement->IsInCustomMode(CMOVE_Grapple))
+	{
+		State.State = ETraversalState::Grappling;
+		State.Ledge = ClimbMovement->GetTraversalLedge();
+		State.GrapplePoint = ClimbMovement->GetGrappleDestination();
+		State.GrappleDuration = ClimbMovement->GetGrappleTrajectory().Duration;
+	}
+	else if(ClientTraversalState.State == ETraversalState::GrapplePreparing)
+	{
+		// Preparing isn't a movement mode, so check the target the client aims at is a ledge in range
+		FVector AimPoint = ClientTraversalState.GrapplePoint;
+		if(ClimbMovement->ClampToLedge(ClientTraversalState.Ledge, ClimbMovement->MaxGrappleDistance, AimPoint))
+		{
+			State.State = ETraversalState::GrapplePreparing;
+			State.Ledge = ClientTraversalState.Ledge;
+			State.GrapplePoint = AimPoint;
+		}
+	}
+	if(State.State != ETraversalState::None)
+	{
+		State.bIsRotating = ClientTraversalState.bIsRotating;
+		State.SurfaceNormal = ClientTraversalState.SurfaceNormal.GetSafeNormal();
+	}
+	if(State == TraversalRepState) return;
+	TraversalRepState = State;
+	ApplyTraversalState();
+}
+
+void AWallClimbJumpCharacter::OnRep_TraversalState()
+{
+	ApplyTraversalState();
+}
+
+void AWallClimbJumpCharacter::StartInputRecording()
+{
+	InputRecording = MakeUnique<FTraversalInputRecording>();
+	InputRecording->MapName = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+	InputRecording->StartLocation = GetActorLocation();
+	InputRecording->StartRotation = GetActorRotation();
+	PendingInput = FTraversalInputFrame();
+	InputRecordingTime = 0.0;
+}
+
+bool AWallClimbJumpCharacter::StopInputRecording(const FString& Filename)
+{
+	if(!InputRecording) return false;
+	InputRecording->EndLocation = GetActorLocation();
+	const bool bSaved = InputRecording->SaveToFile(Filename);
+	if(bSaved)
+	{
+		UE_LOG(LogTraversal, Display, TEXT("Saved %d frames of traversal input to %s"), InputRecording->Frames.Num(), *Filename);
+	}
+	else
+	{
+		UE_LOG(LogTraversal, Error, TEXT("Failed to save traversal input to %s"), *Filename);
+	}
+	InputRecording.Reset();
+	return bSaved;
+}
+
+void AWallClimbJumpCharacter::RecordInputFrame(const float DeltaTime)
+{
+	PendingInput.Time = InputRecordingTime;
+	if(Controller)
+	{
+		PendingInput.SetControlRotation(Controller->GetControlRotation());
+	}
+	InputRecording->Frames.Add(PendingInput);
+	// Axes are sent every frame, actions only when they happen
+	PendingInput.Actions = ETraversalInputAction::None;
+	InputRecordingTime += DeltaTime;
+}
+
+void AWallClimbJumpCharacter::ApplyTraversalState()
+{
+	const ETraversalState State = TraversalRepState.State;
+	if(State == ETraversalState::Grappling && !bIsGrappling)
+	{
+		ReplicatedGrappleLandTime = GetWorld()->GetTimeSeconds() + TraversalRepState.GrappleDuration;
+	}
+	bIsClimbing = State == ETraversalState::Climbing;
+	bIsHoldingLedge = State == ETraversalState::Hanging;
+	bIsGrappling = State == ETraversalState::Grappling;
+	bIsGrapplePreparing = bIsGrappling || State == ETraversalState::GrapplePreparing;
+	bIsRotating = TraversalRepState.bIsRotating;
+	RotateNormal = TraversalRepState.SurfaceNormal;
+	GrappleNormal = TraversalRepState.SurfaceNormal;
+	GrapplePoint = TraversalRepState.GrapplePoint;
+	MoveDirection = TraversalRepState.ShimmyDirection;
+	CurrentLedge = bIsHoldingLedge ? TraversalRepState.Ledge : nullptr;
+	TargetLedge = bIsGrapplePreparing ? TraversalRepState.Ledge : nullptr;
+	AnimState.bIsClimbing = bIsClimbing;
+	AnimState.bIsHolding = bIsHoldingLedge;
+	AnimState.bIsGrappling = bIsGrapplePreparing;
+	AnimState.Direction = MoveDirection;
+	if(!bIsClimbing)
+	{
+		SetPoseFrozen(false);
+	}
+	CableLocalPosition = GrapplePoint;
+	if(bIsGrappling)
+	{
+		WakeCable(true);
+	}
+	else
+	{
+		SleepCable();
+	}
+}
+
+void AWallClimbJumpCharacter::HandleLedgeSweep(const bool bHit, const FHitResult& LedgeOutHit)
+{
+	ALedge* HitLedge = bHit ? Cast<ALedge>(LedgeOutHit.Actor) : nullptr;
+	if(HitLedge)
+	{
+		SelectedLedge = HitLedge;
+		ShowPrompt(ETraversalPrompt::JumpToLedge);
+	}
+	else
+	{
+		SelectedLedge = nullptr;
+		HidePrompt(ETraversalPrompt::JumpToLedge);
+	}
+}
+
+void AWallClimbJumpCharacter::HandleWallTrace(const bool bHit, const FHitResult& WallOutHit)
+{
+	if(bHit)
 	{
 		AClimbableWall* HitWall = Cast<AClimbableWall>(WallOutHit.Actor);
 		
@@ -223,6 +627,29 @@ void AWallClimbJumpCharacter::Tick(float DeltaTime)
 	WallUndetected();
 }
 
+void AWallClimbJumpCharacter::OnLedgeSweepDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	// State may have changed since the sweep was queued last frame
+	if(bIsHoldingLedge || bIsGrappling || bIsGrapplePreparing) return;
+	if(!ShouldSweepForLedges()) return;
+	const FHitResult* Hit = FHitResult::GetFirstBlockingHit(TraceDatum.OutHits);
+	HandleLedgeSweep(Hit != nullptr, Hit ? *Hit : FHitResult());
+}
+
+void AWallClimbJumpCharacter::OnWallTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if(bIsGrappling || bIsGrapplePreparing || WallZones.Num() == 0) return;
+	const FHitResult* Hit = FHitResult::GetFirstBlockingHit(TraceDatum.OutHits);
+	HandleWallTrace(Hit != nullptr, Hit ? *Hit : FHitResult());
+}
+
+void AWallClimbJumpCharacter::OnShimmyTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if(!bIsHoldingLedge) return;
+	const FHitResult* Hit = FHitResult::GetFirstBlockingHit(TraceDatum.OutHits);
+	HandleShimmyTrace(PendingShimmyValue, Hit != nullptr, Hit ? *Hit : FHitResult());
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -257,81 +684,370 @@ void AWallClimbJumpCharacter::SetupPlayerInputComponent(class UInputComponent* P
 
 void AWallClimbJumpCharacter::LocateTarget()
 {
-	ALedge* ClosestLedge = nullptr;
-	GrapplePoint = FVector::ZeroVector;
+	TRAVERSAL_SCOPE_CYCLE_COUNTER(STAT_TraversalLocateTarget);
+	TRAVERSAL_SCOPE_FRAME_TIMER(LocateTargetCycles);
+	const FVector ActorLoc = GetActorLocation();
 	// if(CurrentLedge)
 	// {
 	// 	DrawDebugSphere(GetWorld(), CurrentLedge->GetActorLocation(), 20, 12, FColor::Blue, false, -1);
 	// }
-	for (const auto& Ledge : Ledges)
+	if(TargetScanCursor == 0)
 	{
-		if(bIsHoldingLedge && CurrentLedge == Ledge)
+		// Start a new sweep over every ledge currently in range
+		// Without a range the grid can't rule anything out, so walk the registry's own array rather than copying and sorting it
+		bSweepAllLedges = LedgeRegistry && GrappleRange <= 0.f;
+		if(LedgeRegistry && !bSweepAllLedges)
 		{
-			continue;
+			LedgeRegistry->QuerySphere(ActorLoc, GetGrappleRange(), LedgeCandidates);
 		}
-		// DrawDebugSphere(GetWorld(), GrapplePoint, 20, 12, FColor::Green, false, -1);
-		FVector ClosestPoint;
-		const float Distance = Ledge->ActorGetDistanceToCollision(GetActorLocation(), ECC_GameTraceChannel1, ClosestPoint);
-		if(Distance <= 0) continue;
-		if(!Ledge->IsOnScreen(ClosestPoint)) continue;
-		
-		if (UKismetMathLibrary::Vector_Distance(ClosestPoint, GetActorLocation()) <= UKismetMathLibrary::Vector_Distance(GrapplePoint, GetActorLocation()) || GrapplePoint == FVector::ZeroVector)
+		else
 		{
-			ClosestLedge = Ledge;
-			GrapplePoint = ClosestPoint;
+			LedgeCandidates.Reset();
 		}
+		SweepBestLedge = nullptr;
+		SweepBestPoint = FVector::ZeroVector;
+	}
+	const TArray<ALedge*>& SweepLedges = GetSweepLedges();
+	// Sweeps big enough to be worth spreading across workers are finished in one go rather than sliced
+	const int32 ParallelThreshold = CVarTraversalParallelTargetThreshold.GetValueOnGameThread();
+	const bool bScoreInParallel = ParallelThreshold > 0 && SweepLedges.Num() - TargetScanCursor >= ParallelThreshold;
+	const int32 SliceEnd = TargetSliceSize > 0 && !bScoreInParallel ? FMath::Min(TargetScanCursor + TargetSliceSize, SweepLedges.Num()) : SweepLedges.Num();
+
+	// The current target is refreshed every frame, the rest of the sweep a slice at a time
+	SliceLedges.Reset();
+	CandidatePoints.Reset();
+	VisibilityBatch.Reset();
+	AddTargetCandidate(TargetLedge, ActorLoc);
+	for(int32 Index = TargetScanCursor; Index < SliceEnd && !bScoreInParallel; ++Index)
+	{
+		if(SweepLedges[Index] != TargetLedge)
+		{
+			AddTargetCandidate(SweepLedges[Index], ActorLoc);
+		}
+	}
+
+	FLedgeScreenView ScreenView;
+	bool bHasScreenView = ScreenView.Capture(GetWorld()->GetFirstPlayerController());
+	if(!bHasScreenView && HeadlessViewSize.X > 0)
+	{
+		// No player viewport to test against, look through the follow camera instead
+		FMinimalViewInfo CameraView;
+		FollowCamera->GetCameraView(0.f, CameraView);
+		bHasScreenView = ScreenView.Capture(CameraView, HeadlessViewSize);
 	}
-	if(ClosestLedge)
+	if(!bHasScreenView)
 	{
-		TargetLedge = ClosestLedge;
-		TargetActor->SetActorLocation(GrapplePoint + FollowCamera->GetForwardVector() * -55);
-		TargetActor->SetActorRotation(FRotator(0, UKismetMathLibrary::FindLookAtRotation(GrapplePoint,FollowCamera->GetComponentLocation()).Yaw,0));
-		TargetActor->ShowTarget(true);
+		CandidateVisibility.Init(false, VisibilityBatch.Num());
 	}
 	else
 	{
-		TargetActor->ShowTarget(false);
+		VisibilityBatch.Compute(ScreenView, CandidateVisibility);
+	}
+
+	ALedge* CurrentTarget = nullptr;
+	FVector CurrentPoint = FVector::ZeroVector;
+	for (int32 Index = 0; Index < SliceLedges.Num(); ++Index)
+	{
+		if(!CandidateVisibility[Index]) continue;
+		// DrawDebugSphere(GetWorld(), GrapplePoint, 20, 12, FColor::Green, false, -1);
+		const FVector& ClosestPoint = CandidatePoints[Index];
+		if(SliceLedges[Index] == TargetLedge)
+		{
+			CurrentTarget = TargetLedge;
+			CurrentPoint = ClosestPoint;
+			continue;
+		}
+		if (!SweepBestLedge || UKismetMathLibrary::Vector_Distance(ClosestPoint, ActorLoc) <= UKismetMathLibrary::Vector_Distance(SweepBestPoint, ActorLoc))
+		{
+			SweepBestLedge = SliceLedges[Index];
+			SweepBestPoint = ClosestPoint;
+		}
+	}
+	if(bScoreInParallel)
+	{
+		ScoreTargetCandidatesParallel(bHasScreenView ? &ScreenView : nullptr, ActorLoc, TargetScanCursor, SliceEnd);
 	}
+	TargetScanCursor = SliceEnd;
+
+	// A challenger only takes over once the sweep is complete and it beats the current target by the hysteresis margin
+	const bool bSweepDone = TargetScanCursor >= SweepLedges.Num();
+	ALedge* NewTarget = CurrentTarget;
+	FVector NewPoint = CurrentPoint;
+	if(SweepBestLedge && (bSweepDone || !CurrentTarget))
+	{
+		if(!CurrentTarget || UKismetMathLibrary::Vector_Distance(SweepBestPoint, ActorLoc) + TargetHysteresis < UKismetMathLibrary::Vector_Distance(CurrentPoint, ActorLoc))
+		{
+			NewTarget = SweepBestLedge;
+			NewPoint = SweepBestPoint;
+		}
+	}
+	if(bSweepDone)
+	{
+		TargetScanCursor = 0;
+	}
+
+	TargetLedge = NewTarget;
+	GrapplePoint = NewTarget ? NewPoint : FVector::ZeroVector;
+	UpdateTargetMarker();
 }
 
-void AWallClimbJumpCharacter::Detach()
+void AWallClimbJumpCharacter::AddTargetCandidate(ALedge* Ledge, const FVector& ActorLoc)
+{
+	if(!IsValid(Ledge)) return;
+	if(bIsHoldingLedge && CurrentLedge == Ledge) return;
+	TRAVERSAL_COUNT_LEDGE();
+	FVector ClosestPoint;
+	const float Distance = Ledge->GetDistanceToGrabPoint(ActorLoc, ClosestPoint);
+	if(Distance <= 0 || Distance > GetGrappleRange()) return;
+	SliceLedges.Add(Ledge);
+	CandidatePoints.Add(ClosestPoint);
+	VisibilityBatch.Add(ClosestPoint);
+}
+
+void AWallClimbJumpCharacter::ScoreTargetCandidatesParallel(const FLedgeScreenView* ScreenView, const FVector& ActorLoc, const int32 Begin, const int32 End)
 {
-	if(AnimController)
+	TRAVERSAL_SCOPE_CYCLE_COUNTER(STAT_TraversalScoreTargetsParallel);
+	const TArray<ALedge*>& SweepLedges = GetSweepLedges();
+	const int32 NumChunks = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, FMath::DivideAndRoundUp(End - Begin, MinTargetScoringChunk));
+	const int32 ChunkSize = FMath::DivideAndRoundUp(End - Begin, NumChunks);
+	if(TargetScoringChunks.Num() < NumChunks)
 	{
-		AnimController->bIsClimbing = false;
+		TargetScoringChunks.SetNum(NumChunks);
+	}
+
+	// Ledges don't change while the game thread waits here, so workers read them directly and only write their own chunk
+	ParallelFor(NumChunks, [this, &SweepLedges, ScreenView, &ActorLoc, Begin, End, ChunkSize](const int32 ChunkIndex)
+	{
+		LLM_SCOPE_BYTAG(Traversal);
+		FTargetScoringChunk& Chunk = TargetScoringChunks[ChunkIndex];
+		Chunk.Reset();
+		const int32 ChunkEnd = FMath::Min(Begin + (ChunkIndex + 1) * ChunkSize, End);
+		for(int32 Index = Begin + ChunkIndex * ChunkSize; Index < ChunkEnd; ++Index)
+		{
+			ALedge* Ledge = SweepLedges[Index];
+			if(Ledge == TargetLedge || !IsValid(Ledge)) continue;
+			if(bIsHoldingLedge && CurrentLedge == Ledge) continue;
+			++Chunk.NumEvaluated;
+			// Distance to complex collision is a physics query, those stay on the game thread
+			if(!Ledge->HasGrabSegment())
+			{
+				Chunk.Deferred.Add(Index);
+				continue;
+			}
+			FVector ClosestPoint;
+			const float Distance = Ledge->GetDistanceToGrabPoint(ActorLoc, ClosestPoint);
+			if(Distance <= 0 || Distance > GetGrappleRange()) continue;
+			Chunk.Indices.Add(Index);
+			Chunk.Points.Add(ClosestPoint);
+			Chunk.Batch.Add(ClosestPoint);
+		}
+		if(!ScreenView) return;
+		Chunk.Batch.Compute(*ScreenView, Chunk.Visibility);
+		for(int32 Candidate = 0; Candidate < Chunk.Indices.Num(); ++Candidate)
+		{
+			if(!Chunk.Visibility[Candidate]) continue;
+			const float Distance = UKismetMathLibrary::Vector_Distance(Chunk.Points[Candidate], ActorLoc);
+			if(IsBetterTargetCandidate(Distance, Chunk.Indices[Candidate], Chunk.BestDistance, Chunk.BestIndex))
+			{
+				Chunk.BestDistance = Distance;
+				Chunk.BestIndex = Chunk.Indices[Candidate];
+				Chunk.BestPoint = Chunk.Points[Candidate];
+			}
+		}
+	});
+
+	int32 NumEvaluated = 0;
+	float BestDistance = 0.f;
+	int32 BestIndex = INDEX_NONE;
+	FVector BestPoint = FVector::ZeroVector;
+	DeferredCandidates.Reset();
+	CandidatePoints.Reset();
+	VisibilityBatch.Reset();
+	for(int32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+	{
+		const FTargetScoringChunk& Chunk = TargetScoringChunks[ChunkIndex];
+		NumEvaluated += Chunk.NumEvaluated;
+		if(Chunk.BestIndex != INDEX_NONE && IsBetterTargetCandidate(Chunk.BestDistance, Chunk.BestIndex, BestDistance, BestIndex))
+		{
+			BestDistance = Chunk.BestDistance;
+			BestIndex = Chunk.BestIndex;
+			BestPoint = Chunk.BestPoint;
+		}
+		for(const int32 Index : Chunk.Deferred)
+		{
+			FVector ClosestPoint;
+			const float Distance = SweepLedges[Index]->GetDistanceToGrabPoint(ActorLoc, ClosestPoint);
+			if(Distance <= 0 || Distance > GetGrappleRange()) continue;
+			DeferredCandidates.Add(Index);
+			CandidatePoints.Add(ClosestPoint);
+			VisibilityBatch.Add(ClosestPoint);
+		}
+	}
+	TRAVERSAL_COUNT_LEDGES(NumEvaluated);
+
+	if(ScreenView && VisibilityBatch.Num() > 0)
+	{
+		VisibilityBatch.Compute(*ScreenView, CandidateVisibility);
+		for(int32 Candidate = 0; Candidate < DeferredCandidates.Num(); ++Candidate)
+		{
+			if(!CandidateVisibility[Candidate]) continue;
+			const float Distance = UKismetMathLibrary::Vector_Distance(CandidatePoints[Candidate], ActorLoc);
+			if(IsBetterTargetCandidate(Distance, DeferredCandidates[Candidate], BestDistance, BestIndex))
+			{
+				BestDistance = Distance;
+				BestIndex = DeferredCandidates[Candidate];
+				BestPoint = CandidatePoints[Candidate];
+			}
+		}
 	}
-	GetMesh()->GlobalAnimRateScale = 1.0f;
+
+	// Earlier slices of the sweep come first, so the slice's best takes over on a tie like it would serially
+	if(BestIndex != INDEX_NONE && (!SweepBestLedge || BestDistance <= UKismetMathLibrary::Vector_Distance(SweepBestPoint, ActorLoc)))
+	{
+		SweepBestLedge = SweepLedges[BestIndex];
+		SweepBestPoint = BestPoint;
+	}
+}
+
+const TArray<ALedge*>& AWallClimbJumpCharacter::GetSweepLedges() const
+{
+	return bSweepAllLedges && LedgeRegistry ? LedgeRegistry->GetLedges() : LedgeCandidates;
+}
+
+void AWallClimbJumpCharacter::UpdateTargetMarker()
+{
+	if(!TargetLedge)
+	{
+		SetTargetMarkerVisible(false);
+		return;
+	}
+	// In screen mode the HUD draws the reticle from GrapplePoint, there is nothing to move
+	if(TargetActor)
+	{
+		const FVector MarkerLocation = GrapplePoint + FollowCamera->GetForwardVector() * -55;
+		const FRotator MarkerRotation(0, UKismetMathLibrary::FindLookAtRotation(GrapplePoint,FollowCamera->GetComponentLocation()).Yaw,0);
+		// Skip the transform update while the marker would stay where it is
+		if(!MarkerLocation.Equals(MarkerAppliedLocation, 1.f) || !MarkerRotation.Equals(MarkerAppliedRotation, 1.f))
+		{
+			TargetActor->SetActorLocationAndRotation(MarkerLocation, MarkerRotation);
+			MarkerAppliedLocation = MarkerLocation;
+			MarkerAppliedRotation = MarkerRotation;
+		}
+	}
+	SetTargetMarkerVisible(true);
+}
+
+void AWallClimbJumpCharacter::SetTargetMarkerVisible(const bool bVisible)
+{
+	if(bTargetMarkerVisible == bVisible) return;
+	bTargetMarkerVisible = bVisible;
+	if(TargetActor)
+	{
+		TargetActor->ShowTarget(bVisible);
+	}
+}
+
+bool AWallClimbJumpCharacter::GetScreenMarkerLocation(FVector& OutLocation) const
+{
+	if(GrappleMarkerMode != EGrappleMarkerMode::Screen || !bTargetMarkerVisible) return false;
+	OutLocation = GrapplePoint;
+	return true;
+}
+
+void AWallClimbJumpCharacter::Detach()
+{
+	AnimState.bIsClimbing = false;
+	SetPoseFrozen(false);
 	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
 	bIsClimbing = false;
-	GetCharacterMovement()->bOrientRotationToMovement = true;
-	HidePrompt("E - Stop Climbing");
+	HidePrompt(ETraversalPrompt::StopClimbing);
+}
+
+void AWallClimbJumpCharacter::AdvanceGrappleWindup(const float DeltaTime)
+{
+	const float PreviousTime = GrappleWindupTime;
+	GrappleWindupTime += DeltaTime;
+	if(PreviousTime < GrappleCableDelay && GrappleWindupTime >= GrappleCableDelay)
+	{
+		FireCable();
+	}
+	if(GrappleWindupTime >= GrappleLaunchDelay)
+	{
+		Grapple();
+	}
 }
 
 void AWallClimbJumpCharacter::FireCable()
 {
-	GetWorld()->GetTimerManager().ClearTimer(GrappleRopeH);
+	TRAVERSAL_SCOPE_ALLOCATIONS();
 	CableLocalPosition = GrapplePoint;
+	WakeCable(false);
+}
+
+void AWallClimbJumpCharacter::WakeCable(const bool bTaut)
+{
+	TRAVERSAL_SCOPE_ALLOCATIONS();
+	if(bTaut)
+	{
+		if(!bCableTaut)
+		{
+			SleepCable();
+			bCableTaut = true;
+			TautCableMesh->SetVisibility(true);
+		}
+		UpdateTautCable();
+		return;
+	}
+	if(bCableTaut)
+	{
+		SleepCable();
+	}
 	CableComponent->AttachEndTo.OtherActor = this;
 	CableComponent->AttachEndTo.ComponentProperty = "CableComponent";
 	CableComponent->EndLocation = UKismetMathLibrary::InverseTransformLocation(CableComponent->GetComponentTransform(), CableLocalPosition);
+	CableComponent->CableLength = CableComponent->EndLocation.Size() * SlackCableLengthScale;
+	if(bCableAwake) return;
+	bCableAwake = true;
+	CableComponent->SetComponentTickEnabled(true);
 	CableComponent->SetVisibility(true);
 }
 
+void AWallClimbJumpCharacter::UpdateTautCable()
+{
+	// The cylinder is 100 units tall and across, centred on its origin
+	const FVector Start = CableComponent->GetComponentLocation();
+	const FVector Span = CableLocalPosition - Start;
+	const float Width = CableComponent->CableWidth / 100.f;
+	TautCableMesh->SetWorldTransform(FTransform(FRotationMatrix::MakeFromZ(Span).Rotator(), Start + Span * 0.5f, FVector(Width, Width, Span.Size() / 100.f)));
+}
+
+void AWallClimbJumpCharacter::SleepCable()
+{
+	if(bCableTaut)
+	{
+		bCableTaut = false;
+		TautCableMesh->SetVisibility(false);
+	}
+	if(!bCableAwake) return;
+	bCableAwake = false;
+	CableComponent->SetComponentTickEnabled(false);
+	CableComponent->SetVisibility(false);
+}
+
 void AWallClimbJumpCharacter::StartGrapple()
 {
-	if(!TargetActor) return;
+	TRAVERSAL_SCOPE_ALLOCATIONS();
+	if(InputRecording) PendingInput.Actions |= ETraversalInputAction::Grapple;
 	if (bIsGrapplePreparing || bIsGrappling) return;
 	if (GrapplePoint == FVector::ZeroVector) return;
 	bIsGrapplePreparing = true;
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(this);
-	CollisionParams.AddIgnoredActor(TargetActor);
 	FHitResult GrappleOutHit;
 	FVector StartPos = GetActorLocation();
 	GrapplePoint.Z = TargetLedge->GetActorLocation().Z;
 	StartPos.Z = GrapplePoint.Z;
 	FVector EndPos = GrapplePoint + UKismetMathLibrary::GetDirectionUnitVector(StartPos, GrapplePoint) * 1;
-	bool FrontHit = GetWorld()->LineTraceSingleByChannel(GrappleOutHit, StartPos, EndPos, ECC_GameTraceChannel1, CollisionParams);
+	TRAVERSAL_COUNT_TRACE();
+	bool FrontHit = GetWorld()->LineTraceSingleByChannel(GrappleOutHit, StartPos, EndPos, ECC_GameTraceChannel1, TraversalQueryParams);
 	// DrawDebugLine(GetWorld(), StartPos, EndPos, FColor::Blue, false, 10, 0, 2);
 	if(!FrontHit || GrappleOutHit.Actor != TargetLedge) {bIsGrapplePreparing = false; return;}
 	// if(GEngine)
@@ -346,30 +1062,33 @@ void AWallClimbJumpCharacter::StartGrapple()
 	// 	GEngine->AddOnScreenDebugMessage(1, 3, FColor::White, RotateNormal.ToCompactString());
 	// }
 	bIsRotating = true;
-	if(AnimController)
-	{
-		AnimController->bIsGrappling = true;
-	}
-	GetWorld()->GetTimerManager().SetTimer(GrappleRopeH, this, &AWallClimbJumpCharacter::FireCable, 1.0f);
-	GetWorld()->GetTimerManager().SetTimer(GrappleLaunchH, this, &AWallClimbJumpCharacter::Grapple, 3.0f);
+	AnimState.bIsGrappling = true;
+	GrappleWindupTime = 0.f;
 }
 
 void AWallClimbJumpCharacter::Grapple()
 {
-	GetWorld()->GetTimerManager().ClearTimer(GrappleLaunchH);
+	TRAVERSAL_SCOPE_ALLOCATIONS();
 	bIsGrappling = true;
-	GetCharacterMovement()->SetMovementMode(MOVE_Flying);
-	GetCharacterMovement()->StopMovementImmediately();
 	// if(GEngine)
 	// {
 	// 	GEngine->AddOnScreenDebugMessage(1, 3, FColor::White, CableComponent->EndLocation.ToString());
 	// }
 	GrapplePoint.Z += HoldOffset.Z;
+	ClimbMovement->StartGrappleTravel(GrapplePoint, TargetLedge);
+	WakeCable(true);
 }
 
 void AWallClimbJumpCharacter::GrappleTravel(const float DeltaTime)
 {
-	CableComponent->EndLocation = UKismetMathLibrary::InverseTransformLocation(CableComponent->GetComponentTransform(), CableLocalPosition);
+	if(bCableTaut)
+	{
+		UpdateTautCable();
+	}
+	else if(bCableAwake)
+	{
+		CableComponent->EndLocation = UKismetMathLibrary::InverseTransformLocation(CableComponent->GetComponentTransform(), CableLocalPosition);
+	}
 	if(!bIsGrappling) return;
 	RotateNormal = GrappleNormal;
 	// if(GEngine)
@@ -377,66 +1096,54 @@ void AWallClimbJumpCharacter::GrappleTravel(const float DeltaTime)
 	// 	GEngine->AddOnScreenDebugMessage(1, 3, FColor::White, RotateNormal.ToCompactString());
 	// }
 	bIsRotating = true;
-	const FVector NewLocation = UKismetMathLibrary::VInterpTo(GetActorLocation(), GrapplePoint, DeltaTime, 10);
-	if(NewLocation != GrapplePoint)
-	{
-		SetActorLocation(NewLocation);
-	}
-	else
-	{
-		CableComponent->SetVisibility(false);
-		if(AnimController)
-		{
-			AnimController->bIsGrappling = false;
-			AnimController->bIsHolding = true;
-		}
-		CurrentLedge = TargetLedge;
-		bIsGrappling = false;
-		bIsHoldingLedge = true;
-		bIsGrapplePreparing = false;
-		GrabLedge(NewLocation);
-	}
+}
+
+void AWallClimbJumpCharacter::OnGrappleArrived(const bool bHanging)
+{
+	SleepCable();
+	AnimState.bIsGrappling = false;
+	bIsGrappling = false;
+	bIsGrapplePreparing = false;
+	if(!bHanging) return;
+	// The movement component has already put the capsule on the ledge
+	AnimState.bIsHolding = true;
+	CurrentLedge = TargetLedge;
+	bIsHoldingLedge = true;
+	ShowPrompt(ETraversalPrompt::LetGo);
+}
+
+float AWallClimbJumpCharacter::GetGrappleTimeRemaining() const
+{
+	if(ClimbMovement->IsInCustomMode(CMOVE_Grapple)) return ClimbMovement->GetGrappleTimeRemaining();
+	// Proxies don't simulate the pull, count down from when the replicated state said it started
+	if(bIsGrappling) return FMath::Max(ReplicatedGrappleLandTime - GetWorld()->GetTimeSeconds(), 0.f);
+	return 0.f;
 }
 
 void AWallClimbJumpCharacter::GrabLedge(const FVector HangLocation)
 {
 	bIsHoldingLedge = true;
-	if(AnimController)
-	{
-		AnimController->bIsHolding = true;
-		// if(GEngine) GEngine->AddOnScreenDebugMessage(-1, 5, FColor::White, FString("Set holding true"));
-	}
-	SetActorLocation(HangLocation);
-	GetCharacterMovement()->MaxFlySpeed = 50;
-	GetCharacterMovement()->BrakingDecelerationFlying = 110;
-	GetCharacterMovement()->bOrientRotationToMovement = false;
-	GetCharacterMovement()->SetMovementMode(MOVE_Flying);
-	GetCharacterMovement()->StopMovementImmediately();
-	ShowPrompt("Space - Let Go");
+	AnimState.bIsHolding = true;
+	ClimbMovement->StartHanging(HangLocation, CurrentLedge);
+	ShowPrompt(ETraversalPrompt::LetGo);
 }
 
 void AWallClimbJumpCharacter::WallAttach()
 {
+	if(InputRecording) PendingInput.Actions |= ETraversalInputAction::Climb;
 	if(bIsClimbing)
 	{
-		ShowPrompt("E - Climb");
+		ShowPrompt(ETraversalPrompt::Climb);
 		Detach();
 	}
 	else if(SelectedWall)
 	{
-		if(AnimController)
-		{
-			AnimController->bIsClimbing = true;
-		}
+		AnimState.bIsClimbing = true;
 		bIsClimbing = true;
 		bIsRotating = true;
-		GetCharacterMovement()->MaxFlySpeed = 100;
-		GetCharacterMovement()->BrakingDecelerationFlying = 80;
-		GetCharacterMovement()->bOrientRotationToMovement = false;
-		GetCharacterMovement()->SetMovementMode(MOVE_Flying);
-		GetCharacterMovement()->StopMovementImmediately();
+		ClimbMovement->StartClimbing();
 		
-		ShowPrompt("E - Stop Climbing");
+		ShowPrompt(ETraversalPrompt::StopClimbing);
 	}
 }
 
@@ -448,7 +1155,7 @@ void AWallClimbJumpCharacter::WallDetected(AClimbableWall* NewWall)
 		bIsRotating = true;
 		return;
 	}
-	ShowPrompt("E - Climb");
+	ShowPrompt(ETraversalPrompt::Climb);
 }
 
 void AWallClimbJumpCharacter::WallUndetected()
@@ -464,23 +1171,73 @@ void AWallClimbJumpCharacter::WallUndetected()
 	}
 	else
 	{
-		HidePrompt("E - Climb");
+		HidePrompt(ETraversalPrompt::Climb);
+	}
+}
+
+void AWallClimbJumpCharacter::EnterWallZone(AClimbableWall* Wall)
+{
+	WallZones.AddUnique(Wall);
+}
+
+void AWallClimbJumpCharacter::ExitWallZone(AClimbableWall* Wall)
+{
+	WallZones.Remove(Wall);
+	if(Wall == SelectedWall || WallZones.Num() == 0)
+	{
+		WallUndetected();
+	}
+}
+
+void AWallClimbJumpCharacter::EnterLedgeVolume(ALedge* Ledge)
+{
+	LedgeVolumes.AddUnique(Ledge);
+}
+
+void AWallClimbJumpCharacter::ExitLedgeVolume(ALedge* Ledge)
+{
+	LedgeVolumes.Remove(Ledge);
+	if(!ShouldSweepForLedges())
+	{
+		SelectedLedge = nullptr;
+		HidePrompt(ETraversalPrompt::JumpToLedge);
 	}
 }
 
-void AWallClimbJumpCharacter::ShowPrompt(FString NewText)
+bool AWallClimbJumpCharacter::ShouldSweepForLedges() const
+{
+	// Ledges without a grab volume can only be found by sweeping everywhere
+	return LedgeVolumes.Num() > 0 || (LedgeRegistry && LedgeRegistry->NumWithoutGrabVolume() > 0);
+}
+
+const FText& AWallClimbJumpCharacter::GetPromptText(const ETraversalPrompt Prompt)
+{
+	// Built once, the widget is only handed a shared reference when the prompt changes
+	static const FText PromptTexts[] =
+	{
+		FText::GetEmpty(),
+		LOCTEXT("JumpToLedgePrompt", "Space - Jump to Ledge"),
+		LOCTEXT("LetGoPrompt", "Space - Let Go"),
+		LOCTEXT("ClimbPrompt", "E - Climb"),
+		LOCTEXT("StopClimbingPrompt", "E - Stop Climbing"),
+	};
+	static_assert(UE_ARRAY_COUNT(PromptTexts) == static_cast<int32>(ETraversalPrompt::MAX), "Every traversal prompt needs a text");
+	return PromptTexts[static_cast<int32>(Prompt)];
+}
+
+void AWallClimbJumpCharacter::ShowPrompt(const ETraversalPrompt Prompt)
 {
 	if(!PromptWidget) return;
-	if(CurrentPrompt == NewText) return;
-	CurrentPrompt = NewText;
-	PromptWidget->ShowPrompt(FText::FromString(NewText));
+	if(CurrentPrompt == Prompt) return;
+	CurrentPrompt = Prompt;
+	PromptWidget->ShowPrompt(GetPromptText(Prompt));
 }
 
-void AWallClimbJumpCharacter::HidePrompt(FString NewText)
+void AWallClimbJumpCharacter::HidePrompt(const ETraversalPrompt Prompt)
 {
 	if(!PromptWidget) return;
-	if(CurrentPrompt != NewText) return;
-	CurrentPrompt = nullptr;
+	if(CurrentPrompt != Prompt) return;
+	CurrentPrompt = ETraversalPrompt::None;
 	PromptWidget->HidePrompt();
 }
 
@@ -513,6 +1270,7 @@ void AWallClimbJumpCharacter::HidePrompt(FString NewText)
 
 void AWallClimbJumpCharacter::MoveForward(const float Value)
 {
+	if(InputRecording) PendingInput.SetForward(Value);
 	if (Controller && Value != 0.0f)
 	{
 		if(bIsHoldingLedge || bIsGrapplePreparing || bIsGrappling) return;
@@ -522,7 +1280,7 @@ void AWallClimbJumpCharacter::MoveForward(const float Value)
 
 		if(bIsClimbing)
 		{
-			GetMesh()->GlobalAnimRateScale = 1.0f;
+			SetPoseFrozen(false);
 			AddMovementInput(GetActorUpVector(), Value, false);
 		}
 		else
@@ -536,56 +1294,43 @@ void AWallClimbJumpCharacter::MoveForward(const float Value)
 
 void AWallClimbJumpCharacter::Jump()
 {
+	TRAVERSAL_SCOPE_ALLOCATIONS();
+	if(InputRecording) PendingInput.Actions |= ETraversalInputAction::Jump;
 	if(CurrentLedge)
 	{
 		// UE_LOG(LogTemp, Warning, TEXT("current ledge"));
 		bIsHoldingLedge = false;
 		bIsRotating = false;
 		CurrentLedge = nullptr;
-		GetCharacterMovement()->bOrientRotationToMovement = true;
 		if(!RightLedge && MoveDirection > 0)
 		{
 			// UE_LOG(LogTemp, Warning, TEXT("right ledge"));
-			if(AnimController)
-			{
-				AnimController->JumpDirection = EJumpDirection::Right;
-				AnimController->bIsJumpingOff = true;
-			}
-			GetCharacterMovement()->AddImpulse(GetActorRightVector() * 970, true);
-			GetCharacterMovement()->SetMovementMode(MOVE_Falling);
+			AnimState.JumpDirection = EJumpDirection::Right;
+			AnimState.bIsJumpingOff = true;
+			ClimbMovement->HopOffLedge(1);
 		}
 		else if(!LeftLedge && MoveDirection < 0)
 		{
 			// UE_LOG(LogTemp, Warning, TEXT("left ledge"));
-			if(AnimController)
-			{
-				AnimController->JumpDirection = EJumpDirection::Left;
-				AnimController->bIsJumpingOff = true;
-			}
-			GetCharacterMovement()->AddImpulse(GetActorRightVector() * -970, true);
-			GetCharacterMovement()->SetMovementMode(MOVE_Falling);
+			AnimState.JumpDirection = EJumpDirection::Left;
+			AnimState.bIsJumpingOff = true;
+			ClimbMovement->HopOffLedge(-1);
 		}
 		else
 		{
 			GetCharacterMovement()->SetMovementMode(MOVE_Walking);
 		}
-		if(AnimController)
-		{
-			AnimController->bIsHolding = false;
-		}
-		HidePrompt("Space - Let Go");
+		AnimState.bIsHolding = false;
+		HidePrompt(ETraversalPrompt::LetGo);
 	}
 	else if(SelectedLedge)
 	{
-		if(!TargetActor) return;
 		FVector HangLocation = GetMesh()->GetSocketLocation("hang_Socket");
 		FHitResult FrontOutHit;
-		FCollisionQueryParams CollisionParams;
-		CollisionParams.AddIgnoredActor(this);
-		CollisionParams.AddIgnoredActor(TargetActor);
 		FVector StartPos = GetActorLocation() + GetActorUpVector() * 140;
 		FVector EndPos = StartPos + GetActorForwardVector() * 60;
-		bool FrontHit = GetWorld()->LineTraceSingleByChannel(FrontOutHit, StartPos, EndPos, ECC_GameTraceChannel1, CollisionParams);
+		TRAVERSAL_COUNT_TRACE();
+		bool FrontHit = GetWorld()->LineTraceSingleByObjectType(FrontOutHit, StartPos, EndPos, LedgeObjectParams, TraversalQueryParams);
 		// DrawDebugLine(GetWorld(), StartPos, EndPos, FColor::Blue, false, 10, 0, 2);
 		if(!FrontHit || !Cast<ALedge>(FrontOutHit.Actor)) return;
 		RotateNormal = FrontOutHit.ImpactNormal;
@@ -602,6 +1347,7 @@ void AWallClimbJumpCharacter::Jump()
 
 void AWallClimbJumpCharacter::StopJumping()
 {
+	if(InputRecording) PendingInput.Actions |= ETraversalInputAction::StopJumping;
 	if(bIsClimbing || bIsHoldingLedge)
 	{
 		return;
@@ -611,13 +1357,23 @@ void AWallClimbJumpCharacter::StopJumping()
 
 void AWallClimbJumpCharacter::MoveRight(float Value)
 {
+	TRAVERSAL_SCOPE_ALLOCATIONS();
+	LLM_SCOPE_BYTAG(Traversal);
+	if(InputRecording) PendingInput.SetRight(Value);
 	if(bIsHoldingLedge)
 	{
-		if(!TargetActor) return;
 		MoveDirection = Value;
-		FCollisionQueryParams CollisionParams;
-		CollisionParams.AddIgnoredActor(this);
-		CollisionParams.AddIgnoredActor(TargetActor);
+		if(Value != 0 && LedgeRegistry && CurrentLedge && CurrentLedge->HasGrabSegment())
+		{
+			// Linked ledge spans say whether the edge carries on, so straight edges need no traces
+			if(ALedge* LedgeUnder = LedgeRegistry->FindLedgeAlongSpan(CurrentLedge, GetActorLocation(), 0.f))
+			{
+				CurrentLedge = LedgeUnder;
+			}
+			const float SpanSign = FVector::DotProduct(GetActorRightVector(), CurrentLedge->GetGrabSegment().GetDirection()) >= 0 ? 1.f : -1.f;
+			ApplyShimmy(Value, LedgeRegistry->FindLedgeAlongSpan(CurrentLedge, GetActorLocation(), FMath::Sign(Value) * SpanSign * 30));
+			return;
+		}
 		FVector RightStartPos;
 		RightStartPos = GetActorLocation() + (GetActorRightVector() * 30) + (GetActorUpVector() * 120);
 		FVector RightEndPos = RightStartPos + GetActorForwardVector() * 40;
@@ -625,86 +1381,37 @@ void AWallClimbJumpCharacter::MoveRight(float Value)
 		FVector LeftEndPos = LeftStartPos + GetActorForwardVector() * 40;
 		// DrawDebugLine(GetWorld(), RightStartPos, RightEndPos, FColor::Blue, false, 0.5, 0, 2);
 		// DrawDebugLine(GetWorld(), LeftStartPos, LeftEndPos, FColor::Green, false, 0.5, 0, 2);
-		if(Value > 0)
+		TRAVERSAL_SCOPE_CYCLE_COUNTER(STAT_TraversalShimmyTrace);
+		if(Value != 0)
+		{
+			TRAVERSAL_COUNT_TRACE();
+		}
+		if(Value != 0 && CVarTraversalAsyncTraces.GetValueOnGameThread())
+		{
+			// The result is applied next frame through OnShimmyTraceDone
+			PendingShimmyValue = Value;
+			const bool bRight = Value > 0;
+			GetWorld()->AsyncLineTraceByObjectType(EAsyncTraceType::Single, bRight ? RightStartPos : LeftStartPos, bRight ? RightEndPos : LeftEndPos, LedgeObjectParams, TraversalQueryParams, &ShimmyTraceDelegate);
+		}
+		else if(Value > 0)
 		{
 			FHitResult RightOutHit;
-			bool bHitRight;
-			bHitRight = GetWorld()->LineTraceSingleByChannel(RightOutHit, RightStartPos, RightEndPos, ECC_GameTraceChannel1,
-			                                                 CollisionParams);
-			if (bHitRight)
-			{
-				ALedge* HitLedge = Cast<ALedge>(RightOutHit.Actor);
-				if(HitLedge)
-				{
-					RightLedge = HitLedge;
-					if(AnimController)
-					{
-						AnimController->Direction = Value;
-						AddMovementInput(GetActorRightVector(), Value, false);
-					}
-				}
-				else
-				{
-					RightLedge = nullptr;
-					if(AnimController)
-					{
-						AnimController->Direction = 0;
-					}
-				}
-			}
-			else
-			{
-				RightLedge = nullptr;
-				if(AnimController)
-				{
-					AnimController->Direction = 0;
-				}
-			}
+			const bool bHitRight = GetWorld()->LineTraceSingleByObjectType(RightOutHit, RightStartPos, RightEndPos, LedgeObjectParams,
+			                                                               TraversalQueryParams);
+			HandleShimmyTrace(Value, bHitRight, RightOutHit);
 		}
 		else if(Value < 0)
 		{
 			FHitResult LeftOutHit;
-			bool bHitLeft;
-			bHitLeft = GetWorld()->LineTraceSingleByChannel(LeftOutHit, LeftStartPos, LeftEndPos, ECC_GameTraceChannel1,
-			                                                CollisionParams);
-			if (bHitLeft)
-			{
-				ALedge* HitLedge = Cast<ALedge>(LeftOutHit.Actor);
-				if(HitLedge)
-				{
-					LeftLedge = HitLedge;
-					if(AnimController)
-					{
-						AnimController->Direction = Value;
-						AddMovementInput(GetActorRightVector(), Value, false);
-					}
-				}
-				else
-				{
-					LeftLedge = nullptr;
-					if(AnimController)
-					{
-						AnimController->Direction = 0;
-					}
-				}
-			}
-			else
-			{
-				LeftLedge = nullptr;
-				if(AnimController)
-				{
-					AnimController->Direction = 0;
-				}
-			}
+			const bool bHitLeft = GetWorld()->LineTraceSingleByObjectType(LeftOutHit, LeftStartPos, LeftEndPos, LedgeObjectParams,
+			                                                              TraversalQueryParams);
+			HandleShimmyTrace(Value, bHitLeft, LeftOutHit);
 		}
 		else
 		{
 			LeftLedge = nullptr;
 			RightLedge = nullptr;
-			if(AnimController)
-			{
-				AnimController->Direction = 0;
-			}
+			AnimState.Direction = 0;
 		}
 		return;
 	}
@@ -728,3 +1435,31 @@ void AWallClimbJumpCharacter::MoveRight(float Value)
 		AddMovementInput(Direction, Value);
 	}
 }
+
+void AWallClimbJumpCharacter::HandleShimmyTrace(const float Value, const bool bHit, const FHitResult& OutHit)
+{
+	ApplyShimmy(Value, bHit ? Cast<ALedge>(OutHit.Actor) : nullptr);
+}
+
+void AWallClimbJumpCharacter::ApplyShimmy(const float Value, ALedge* LedgeAhead)
+{
+	if(Value > 0)
+	{
+		RightLedge = LedgeAhead;
+	}
+	else
+	{
+		LeftLedge = LedgeAhead;
+	}
+	if(LedgeAhead)
+	{
+		AnimState.Direction = Value;
+		AddMovementInput(GetActorRightVector(), Value, false);
+	}
+	else
+	{
+		AnimState.Direction = 0;
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -3,14 +3,96 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "CharAnimInstance.h"
+#include "LedgeVisibility.h"
+#include "TraversalInputRecording.h"
+#include "WorldCollision.h"
+#include "Engine/NetSerialization.h"
 #include "GameFramework/Character.h"
 #include "WallClimbJumpCharacter.generated.h"
 
+UENUM(BlueprintType)
+enum class EGrappleMarkerMode : uint8
+{
+	/** Spawn TargetActorClass and move its world-space widget onto the target */
+	Actor,
+	/** Let the HUD draw a reticle at the projected grapple point */
+	Screen
+};
+
+UENUM(BlueprintType)
+enum class ETraversalState : uint8
+{
+	None,
+	Climbing,
+	Hanging,
+	GrapplePreparing,
+	Grappling,
+	MAX UMETA(Hidden)
+};
+
+UENUM()
+enum class ETraversalPrompt : uint8
+{
+	None,
+	JumpToLedge,
+	LetGo,
+	Climb,
+	StopClimbing,
+	MAX UMETA(Hidden)
+};
+
+/** What other machines need to present a climber, fields a state doesn't use are neither sent nor kept */
+USTRUCT()
+struct FTraversalRepState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	ETraversalState State = ETraversalState::None;
+	UPROPERTY()
+	bool bIsRotating = false;
+	/** -1, 0 or 1 while shimmying along a ledge */
+	UPROPERTY()
+	int8 ShimmyDirection = 0;
+	UPROPERTY()
+	FVector_NetQuantizeNormal SurfaceNormal = FVector::ZeroVector;
+	UPROPERTY()
+	FVector_NetQuantize10 GrapplePoint = FVector::ZeroVector;
+	/** Length of the grapple pull, sent in milliseconds while grappling so proxies know when it lands */
+	UPROPERTY()
+	float GrappleDuration = 0.f;
+	/** Ledge being hung from or grappled to, sent as its network GUID */
+	UPROPERTY()
+	class ALedge* Ledge = nullptr;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FTraversalRepState& Other) const
+	{
+		return State == Other.State && bIsRotating == Other.bIsRotating && ShimmyDirection == Other.ShimmyDirection
+			&& SurfaceNormal == Other.SurfaceNormal && GrapplePoint == Other.GrapplePoint && GrappleDuration == Other.GrappleDuration && Ledge == Other.Ledge;
+	}
+	bool operator!=(const FTraversalRepState& Other) const { return !(*this == Other); }
+};
+
+template<>
+struct TStructOpsTypeTraits<FTraversalRepState> : public TStructOpsTypeTraitsBase2<FTraversalRepState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
+
 UCLASS(config=Game)
 class AWallClimbJumpCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	friend class UTraversalBenchmarkCommandlet;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class USpringArmComponent* CameraBoom;
@@ -19,14 +101,17 @@ class AWallClimbJumpCharacter : public ACharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;
 
-	UPROPERTY()
-	class UCharAnimInstance* AnimController;
-	
 	UPROPERTY()
 	class AGrappleTarget* TargetActor;
+
+	UPROPERTY()
+	class UClimbMovementComponent* ClimbMovement;
+
+	/** Read by the animation proxy once per update, never touched off the game thread */
+	FTraversalAnimState AnimState;
 	
 public:
-	AWallClimbJumpCharacter();
+	AWallClimbJumpCharacter(const FObjectInitializer& ObjectInitializer);
 
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
@@ -39,25 +124,93 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=UI)
 	TSubclassOf<class UUIWidget> PromptWidgetClass;
 	
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Gameplay)
-	TArray<class ALedge*> Ledges;
+	/** Maximum distance at which a ledge can be picked as a grapple target, 0 keeps every ledge in the level in range. The ledge index only narrows the search once this is set */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Gameplay)
+	float GrappleRange = 0.f;
+
+	/** Ledges re-evaluated per frame when searching for a better grapple target, 0 evaluates every ledge in range each frame */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Gameplay)
+	int32 TargetSliceSize = 64;
+
+	/** How much closer a ledge must be than the current grapple target before the target switches to it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Gameplay)
+	float TargetHysteresis = 25.f;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=UI)
 	TSubclassOf<AGrappleTarget> TargetActorClass;
+	/** How the current grapple target is shown to the player, Screen swaps the spawned marker for a HUD reticle */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=UI)
+	EGrappleMarkerMode GrappleMarkerMode = EGrappleMarkerMode::Actor;
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Gameplay)
 	class UCableComponent* CableComponent;
+	/** Straight rope shown while the grapple pulls, CableComponent only simulates the slack rope before it */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Gameplay)
+	class UStaticMeshComponent* TautCableMesh;
+
+	/** Slack rope length relative to the distance it spans */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Gameplay, meta=(ClampMin="1"))
+	float SlackCableLengthScale = 1.15f;
+
+	/** Stop evaluating the mesh once hanging without moving for HangIdleFreezeDelay seconds */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Animation)
+	bool bFreezePoseWhileHangingIdle = true;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Animation, meta=(EditCondition="bFreezePoseWhileHangingIdle"))
+	float HangIdleFreezeDelay = 1.f;
+	/** Distance from the camera at which this climber's animation is least significant to the budget allocator */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Animation)
+	float AnimationSignificanceRange = 5000.f;
 	
 	void WallDetected(class AClimbableWall* NewWall);
 	void WallUndetected();
-	void ShowPrompt(FString NewText);
-	void HidePrompt(FString NewText);
+	void EnterWallZone(AClimbableWall* Wall);
+	void ExitWallZone(AClimbableWall* Wall);
+	void EnterLedgeVolume(class ALedge* Ledge);
+	void ExitLedgeVolume(class ALedge* Ledge);
+	bool ShouldSweepForLedges() const;
+	static const FText& GetPromptText(ETraversalPrompt Prompt);
+	void ShowPrompt(ETraversalPrompt Prompt);
+	/** Only hides Prompt if it is the one currently shown */
+	void HidePrompt(ETraversalPrompt Prompt);
+	/** Starts capturing the inputs bound in SetupPlayerInputComponent, one frame per tick */
+	void StartInputRecording();
+	/** Writes the recording to Filename and stops, false if nothing was being recorded or the write failed */
+	bool StopInputRecording(const FString& Filename);
+	bool IsRecordingInput() const { return InputRecording.IsValid(); }
 	void Detach();
+	void AdvanceGrappleWindup(float DeltaTime);
 	void FireCable();
+	void WakeCable(bool bTaut);
+	void UpdateTautCable();
+	void SleepCable();
 	void StartGrapple();
 	void Grapple();
 	void GrappleTravel(float DeltaTime);
+	void OnGrappleArrived(bool bHanging);
+	/** Seconds until the current grapple lands, also valid on simulated proxies */
+	float GetGrappleTimeRemaining() const;
+	ETraversalState GetTraversalState() const;
+	void UpdateAlignment();
+	void UpdateAnimationBudget(float DeltaTime);
+	void SetPoseFrozen(bool bFrozen);
 	void GrabLedge(const FVector HangLocation);
 	void LocateTarget();
+	void AddTargetCandidate(class ALedge* Ledge, const FVector& ActorLoc);
+	/** Ledges the current sweep walks, the registry's dense array while the grapple range is unbounded */
+	const TArray<ALedge*>& GetSweepLedges() const;
+	/** Folds GetSweepLedges()[Begin, End) into the sweep's best on worker threads, picking what the serial scan would */
+	void ScoreTargetCandidatesParallel(const FLedgeScreenView* ScreenView, const FVector& ActorLoc, int32 Begin, int32 End);
+	void UpdateTargetMarker();
+	void SetTargetMarkerVisible(bool bVisible);
+	/** World location the HUD should draw the grapple reticle at, false when there is nothing to draw */
+	bool GetScreenMarkerLocation(FVector& OutLocation) const;
+	void HandleLedgeSweep(bool bHit, const FHitResult& LedgeOutHit);
+	void HandleWallTrace(bool bHit, const FHitResult& WallOutHit);
+	void HandleShimmyTrace(float Value, bool bHit, const FHitResult& OutHit);
+	/** Shimmies towards Value if LedgeAhead continues the edge that way, otherwise stops at the end */
+	void ApplyShimmy(float Value, ALedge* LedgeAhead);
+	void OnLedgeSweepDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+	void OnWallTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+	void OnShimmyTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
 
 protected:
 
@@ -67,8 +220,16 @@ protected:
 	UPROPERTY(BlueprintReadOnly, Category="Movement")
 	AClimbableWall* SelectedWall;
 
+	/** Walls whose climb zone currently contains this character */
+	UPROPERTY()
+	TArray<AClimbableWall*> WallZones;
+
 	UPROPERTY(BlueprintReadOnly, Category="Movement")
-	ALedge* SelectedLedge;
+	class ALedge* SelectedLedge;
+
+	/** Ledges whose grab volume currently contains this character */
+	UPROPERTY()
+	TArray<ALedge*> LedgeVolumes;
 	UPROPERTY(BlueprintReadOnly, Category="Movement")
 	ALedge* TargetLedge;
 
@@ -92,10 +253,87 @@ protected:
 	FVector RightWallNormal;
 	FVector CableLocalPosition;
 	float MoveDirection;
-	FString CurrentPrompt;
-	FTimerHandle GrappleLaunchH;
-	FTimerHandle GrappleRopeH;
+	ETraversalPrompt CurrentPrompt = ETraversalPrompt::None;
+	/** Seconds since StartGrapple, counted in Tick since setting a timer binds a new delegate each grapple */
+	float GrappleWindupTime = 0.f;
 	FCollisionShape CapsuleCollisionShape = FCollisionShape::MakeCapsule(14, 70);
+	UPROPERTY()
+	class ULedgeSubsystem* LedgeRegistry;
+	UPROPERTY()
+	TArray<ALedge*> LedgeCandidates;
+	bool bSweepAllLedges = false;
+	UPROPERTY()
+	ALedge* SweepBestLedge;
+	FVector SweepBestPoint;
+	int32 TargetScanCursor = 0;
+	TArray<ALedge*> SliceLedges;
+	FVector MarkerAppliedLocation;
+	FRotator MarkerAppliedRotation;
+	bool bTargetMarkerVisible;
+	TArray<FVector> CandidatePoints;
+	FLedgeVisibilityBatch VisibilityBatch;
+	TBitArray<> CandidateVisibility;
+	/** One worker's share of a parallel target slice, kept between frames so the buffers are reused */
+	struct FTargetScoringChunk
+	{
+		/** Sweep indices of the in-range candidates, with their grab points */
+		TArray<int32> Indices;
+		TArray<FVector> Points;
+		FLedgeVisibilityBatch Batch;
+		TBitArray<> Visibility;
+		/** Complex ledges left for the game thread */
+		TArray<int32> Deferred;
+		int32 NumEvaluated = 0;
+		int32 BestIndex = INDEX_NONE;
+		float BestDistance = 0.f;
+		FVector BestPoint = FVector::ZeroVector;
+
+		void Reset()
+		{
+			Indices.Reset();
+			Points.Reset();
+			Batch.Reset();
+			Deferred.Reset();
+			NumEvaluated = 0;
+			BestIndex = INDEX_NONE;
+		}
+	};
+	TArray<FTargetScoringChunk> TargetScoringChunks;
+	TArray<int32> DeferredCandidates;
+	FTraceDelegate LedgeSweepDelegate;
+	FTraceDelegate WallTraceDelegate;
+	FTraceDelegate ShimmyTraceDelegate;
+	FCollisionQueryParams TraversalQueryParams;
+	/** Ledge finding queries only consider ledge collision proxies */
+	FCollisionObjectQueryParams LedgeObjectParams;
+	/** Viewport size targets are picked at through FollowCamera when there is no player viewport, only set by the benchmark */
+	FIntPoint HeadlessViewSize = FIntPoint::ZeroValue;
+	float PendingShimmyValue = 0.f;
+	float HangIdleTime = 0.f;
+	float ReplicatedGrappleLandTime = 0.f;
+	bool bCableAwake = false;
+	bool bCableTaut = false;
+	TUniquePtr<FTraversalInputRecording> InputRecording;
+	/** Input gathered since the last tick, added to InputRecording as one frame */
+	FTraversalInputFrame PendingInput;
+	double InputRecordingTime;
+
+	/** Replicated to simulated proxies, owning clients send theirs up through ServerSetTraversalState */
+	UPROPERTY(ReplicatedUsing=OnRep_TraversalState)
+	FTraversalRepState TraversalRepState;
+	/** Last state a remote client sent, the server checks it against its own movement before replicating it */
+	FTraversalRepState ClientTraversalState;
+	float NextTraversalStateSendTime = 0.f;
+
+	UFUNCTION()
+	void OnRep_TraversalState();
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSetTraversalState(const FTraversalRepState& NewState);
+	FTraversalRepState MakeTraversalRepState() const;
+	void PublishTraversalState();
+	void ResolveClientTraversalState();
+	void ApplyTraversalState();
+	void RecordInputFrame(float DeltaTime);
 	
 	/** Resets HMD orientation in VR. */
 	// void OnResetVR();
@@ -131,6 +369,7 @@ protected:
 	virtual void StopJumping() override;
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 protected:
 	// APawn interface
@@ -142,5 +381,11 @@ public:
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera sub object **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns the traversal state animation is driven from **/
+	FORCEINLINE const FTraversalAnimState& GetAnimState() const { return AnimState; }
+	/** Returns ClimbMovement sub object **/
+	FORCEINLINE class UClimbMovementComponent* GetClimbMovement() const { return ClimbMovement; }
+	/** Returns GrappleRange, unbounded when it is 0 **/
+	FORCEINLINE float GetGrappleRange() const { return GrappleRange > 0.f ? GrappleRange : TNumericLimits<float>::Max(); }
 };
 
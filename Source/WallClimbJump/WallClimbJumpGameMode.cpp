@@ -2,6 +2,7 @@
 
 #include "WallClimbJumpGameMode.h"
 #include "WallClimbJumpCharacter.h"
+#include "WallClimbJumpHUD.h"
 #include "UObject/ConstructorHelpers.h"
 
 AWallClimbJumpGameMode::AWallClimbJumpGameMode()
@@ -12,4 +13,5 @@ AWallClimbJumpGameMode::AWallClimbJumpGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+	HUDClass = AWallClimbJumpHUD::StaticClass();
 }
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WallClimbJumpHUD.h"
+
+#include "WallClimbJumpCharacter.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/Canvas.h"
+#include "Engine/Texture2D.h"
+
+void AWallClimbJumpHUD::DrawHUD()
+{
+	Super::DrawHUD();
+	if(!Canvas || !PlayerOwner || !PlayerOwner->PlayerCameraManager) return;
+
+	const AWallClimbJumpCharacter* Character = Cast<AWallClimbJumpCharacter>(GetOwningPawn());
+	FVector MarkerLocation;
+	if(!Character || !Character->GetScreenMarkerLocation(MarkerLocation)) return;
+
+	// Project gives garbage for points behind the camera
+	const FVector CameraLocation = PlayerOwner->PlayerCameraManager->GetCameraLocation();
+	const FVector CameraForward = PlayerOwner->PlayerCameraManager->GetCameraRotation().Vector();
+	if(FVector::DotProduct(MarkerLocation - CameraLocation, CameraForward) <= 0) return;
+
+	const FVector ScreenLocation = Project(MarkerLocation);
+	const float HalfSize = ReticleSize * 0.5f;
+	if(ReticleTexture)
+	{
+		DrawTexture(ReticleTexture, ScreenLocation.X - HalfSize, ScreenLocation.Y - HalfSize, ReticleSize, ReticleSize, 0, 0, 1, 1, ReticleColor);
+	}
+	else
+	{
+		DrawLine(ScreenLocation.X - HalfSize, ScreenLocation.Y, ScreenLocation.X + HalfSize, ScreenLocation.Y, ReticleColor, 2.f);
+		DrawLine(ScreenLocation.X, ScreenLocation.Y - HalfSize, ScreenLocation.X, ScreenLocation.Y + HalfSize, ReticleColor, 2.f);
+	}
+}
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/HUD.h"
+#include "WallClimbJumpHUD.generated.h"
+
+/**
+ * Draws the grapple reticle in screen space for characters using EGrappleMarkerMode::Screen.
+ */
+UCLASS()
+class WALLCLIMBJUMP_API AWallClimbJumpHUD : public AHUD
+{
+	GENERATED_BODY()
+
+public:
+	virtual void DrawHUD() override;
+
+	/** Reticle image, a plain crosshair is drawn when unset */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Grapple)
+	class UTexture2D* ReticleTexture;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Grapple)
+	float ReticleSize = 32.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Grapple)
+	FLinearColor ReticleColor = FLinearColor::White;
+};